@@ -1,123 +1,35 @@
+#include "ara.hpp"
+#include "bloom_filter.hpp"
+#include "board.hpp"
+#include "bucket_queue.hpp"
+#include "checkpoint.hpp"
+#include "closed_set.hpp"
+#include "epea.hpp"
+#include "heuristic.hpp"
+#include "move_pruning.hpp"
+#include "node_arena.hpp"
+#include "pattern_database.hpp"
+#include "sma.hpp"
+#include "solution_cache.hpp"
+#include "squared_manhattan.hpp"
+#include "telemetry.hpp"
+
 #include <algorithm>
+#include <cerrno>
 #include <chrono>
-#include <cmath>
-#include <deque>
+#include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <optional>
-#include <playgroundcpp/steps.hh>
-#include <queue>
 #include <signal.h>
+#include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
-struct coord {
-  int x;
-  int y;
-};
-
-coord operator+(const coord &a, const coord &b) { return {a.x + b.x, a.y + b.y}; }
-
-int manhattan_distance(const coord &a, const coord &b) { return std::pow(std::abs(a.x - b.x) + std::abs(a.y - b.y), 2); }
-
-enum Direction { Up, Right, Down, Left, Nothing };
-
-constexpr coord direction_to_coord[]{/*[Up   ] =*/{0, 1},
-                                     /*[Right] =*/{-1, 0},
-                                     /*[Down ] =*/{0, -1},
-                                     /*[Left ] =*/{1, 0}};
-
-coord position_to_coord(int p) { return {p % 4, p / 4}; }
-
-int coord_to_position(const coord &c) { return (c.y * 4) + c.x; }
-
-using Board = uint64_t;
-
-int get_hole_position(const Board &b) {
-  int i = 0;
-  for (auto a = b; a & 0xfull; a >>= 4)
-    i++;
-  return i;
-}
-
-std::vector<std::pair<int, int>> get_positions(const Board &b) {
-  std::vector<std::pair<int, int>> result;
-  uint64_t v = b;
-
-  using namespace playgroundcpp;
-
-  16_times([&v, &result](std::size_t p) {
-    result.push_back({v & 0xfull, p});
-    v >>= 4;
-  });
-
-  return result;
-}
-
-int count_board_inversions(const Board &b) {
-  auto p = get_positions(b);
-  int inversions = 0;
-
-  for (std::size_t i = 0; i < p.size() - 1; i++)
-    for (std::size_t j = i + 1; j < p.size(); j++)
-      if (p[i].first != 0 && p[j].first != 0 && p[i].first > p[j].first)
-        inversions++;
-
-  return inversions;
-}
-
-bool is_board_solvable(const Board &b) {
-  int count = count_board_inversions(b);
-
-  return (count % 2) == 0;
-}
-
-std::optional<Board> move(const Board &b, Direction d) {
-  int hole_pos = get_hole_position(b);
-  coord hole = position_to_coord(hole_pos);
-  coord dest = hole + direction_to_coord[d];
-  if (dest.x < 0 || dest.x > 3 || dest.y < 0 || dest.y > 3)
-    return {};
-
-  int dest_pos = coord_to_position(dest);
-  // v is the value to move to the old hole position
-  uint64_t v = (b & (0xfull << (4 * dest_pos)));
-
-  if (hole_pos > dest_pos)
-    v <<= (4 * (hole_pos - dest_pos));
-  else
-    v >>= (4 * (dest_pos - hole_pos));
-
-  Board new_board = (b | v) & ~(0xfull << (4 * dest_pos));
-
-  return {new_board};
-}
-
-uint64_t manhattam_distances_sum_of(Board b) {
-  uint64_t sum = 0;
-  auto positions = get_positions(b);
-  std::vector<uint64_t> manhattan_distances;
-
-  std::transform(positions.begin(), positions.end(), std::back_inserter(manhattan_distances), [](std::pair<int, int> &p) {
-    int value = p.first;
-    int position = p.second;
-    int corrected_value = 15 - ((value + 15) % 16);
-
-    coord c_orig = position_to_coord(position);
-    coord c_dest = position_to_coord(corrected_value);
-
-    return manhattan_distance(c_orig, c_dest);
-    // return manhattan_distance(c_orig, c_dest) * (corrected_value / 4 == 3 ? 100 : corrected_value % 4 == 3 ? 50 : 1);
-    // return std::pow(manhattan_distance(c_orig, c_dest), corrected_value + 1);
-  });
-
-  std::for_each(manhattan_distances.begin(), manhattan_distances.end(), [&sum](int v) { sum += v; });
-
-  return sum;
-}
-
 struct Status {
   Board board;
   int moves;
@@ -129,14 +41,12 @@ struct Status {
   Status(const Status &) = default;
   Status(Status &&) = default;
 
-  explicit Status(Board board) : board{board}, moves{0}, md{manhattam_distances_sum_of(board)}, direction{Nothing} {}
-
-  Status(Board board, int moves, Direction direction) : board{board}, moves{moves}, md{manhattam_distances_sum_of(board)}, direction{direction} {}
+  Status(Board board, int moves, uint64_t md, Direction direction) : board{board}, moves{moves}, md{md}, direction{direction} {}
 
   Status &operator=(const Status &) = default;
   Status &operator=(Status &&) = default;
 
-  bool is_solved() const { return board == 0x1234'5678'9abc'def0; }
+  bool is_solved() const { return board == solved_board; }
 };
 
 struct status_path {
@@ -152,57 +62,58 @@ struct status_path {
   status_path &operator=(const status_path &) = default;
   status_path &operator=(status_path &&) = default;
 
-  bool has_better_heuristic_than(const status_path &sp) const {
-    uint64_t a_sum = last().moves + last().md;
-    uint64_t b_sum = sp.last().moves + sp.last().md;
-
-    return a_sum < b_sum;
-  }
-
   int moves() const { return path.size() - 1; }
 
-  status_path operator+(const Status &s) const {
-    std::vector<Status> new_vec(path.size() + 1);
-    std::copy(path.begin(), path.end(), new_vec.begin());
-    new_vec[path.size()] = s;
-    return status_path(std::move(new_vec));
-  }
-
   const Status &last() const { return path.back(); }
 
   Status &last() { return path.back(); }
 
   bool is_solved() const { return path.back().is_solved(); }
-
-  bool has_worse_than(const Status &status) {
-    auto it = std::find_if(path.begin(), path.end(), [&status](auto const &s) { return s.board == status.board; });
-    return it != path.end() && it->moves > status.moves;
-  }
 };
 
-struct HeuristicCompareStatus {
-  bool operator()(const status_path &a, const status_path &b) const { return !a.has_better_heuristic_than(b); }
+/**
+ * search_node is what the A* stores for every generated board. The path is not
+ * stored in the node, only the handle of its parent. The full path is rebuilt
+ * walking the parents only when it is needed.
+ *
+ * The moves that close a cycle or repeat a shorter path are pruned with the state
+ * of move_pruning of the node, so the path is never walked to look for them. It
+ * fits in the padding of the node.
+ */
+struct search_node {
+  Board board;
+  node_handle parent;
+  uint16_t moves;
+  Direction direction;
+  move_pruning::state pruning_state;
+
+  bool is_solved() const { return board == solved_board; }
 };
 
-template <class Stream> Stream &operator<<(Stream &s, Direction d) {
-  switch (d) {
-  case Up:
-    s << "Up     ";
-    break;
-  case Right:
-    s << "Right  ";
-    break;
-  case Down:
-    s << "Down   ";
-    break;
-  case Left:
-    s << "Left   ";
-    break;
-  case Nothing:
-    s << "Nothing";
-    break;
+using search_arena = node_arena<search_node>;
+
+/**
+ * rebuild_path walks from the node to the root of the search and returns the
+ * visited status in order, the root first.
+ */
+template <class Heuristic> status_path rebuild_path(const search_arena &nodes, node_handle h, const Heuristic &heuristic) {
+  std::vector<Status> path;
+  for (; h != no_node; h = nodes[h].parent)
+    path.emplace_back(nodes[h].board, nodes[h].moves, heuristic.evaluate(nodes[h].board), nodes[h].direction);
+  std::reverse(path.begin(), path.end());
+  return status_path(std::move(path));
+}
+
+/**
+ * path_of returns the status visited by the moves from the board, the board first.
+ */
+template <class Heuristic> status_path path_of(Board b, const std::vector<Direction> &moves, const Heuristic &heuristic) {
+  status_path path{Status{b, 0, static_cast<uint64_t>(heuristic.evaluate(b)), Nothing}};
+  for (auto d : moves) {
+    b = *move(b, d);
+    path.path.emplace_back(b, path.moves() + 1, heuristic.evaluate(b), d);
   }
-  return s;
+  return path;
 }
 
 template <class Stream> Stream &operator<<(Stream &s, const std::optional<Status> &status);
@@ -229,232 +140,674 @@ template <class Stream> Stream &operator<<(Stream &s, const status_path &status)
   return s;
 }
 
-using priority_queue = std::priority_queue<status_path, std::deque<status_path>, HeuristicCompareStatus>;
+/**
+ * The open list stores the handles of the nodes, in buckets by f = moves + heuristic and by moves,
+ * so comparisons don't need to access the arena.
+ */
+using priority_queue = bucket_queue<node_handle>;
 
-template <class Stream> Stream &operator<<(Stream &s, priority_queue &q) {
-  priority_queue tmp;
+template <class Stream> Stream &operator<<(Stream &s, const priority_queue &q) {
   bool show_comma = false;
 
   s << "[ ";
-  while (!q.empty()) {
+  q.for_each([&s, &show_comma](uint32_t f, uint32_t g, node_handle node) {
     if (show_comma)
       s << ", ";
     else
       show_comma = true;
-    s << q.top().last();
-    tmp.push(q.top());
-    q.pop();
-  }
+    s << "{ f = " << f << ", g = " << g << ", node = " << node << " }";
+  });
   s << " ]";
 
-  while (!tmp.empty()) {
-    q.push(tmp.top());
-    tmp.pop();
-  }
-
   return s;
 }
 
-// From https://en.cppreference.com/w/cpp/algorithm/lower_bound
-template <class Iterator, class T, class Func> Iterator bin_search(Iterator first, Iterator last, const T &v, Func cmp) {
-  first = std::lower_bound(first, last, v, cmp);
-  return first != last && !cmp(v, *first) ? first : last;
+/**
+ * search_options are the parameters of the search read from the command line.
+ */
+struct search_options {
+  Board initial_board = default_board;
+  uint64_t max = 100;
+  std::size_t visited_max_bytes = std::numeric_limits<std::size_t>::max();
+  /**
+   * bloom_max_bytes is the size of the Bloom filter used as closed set instead of the hash
+   * table, or 0 to use the hash table.
+   */
+  std::size_t bloom_max_bytes = 0;
+  std::size_t memory_max_bytes = std::size_t{256} << 20;
+  /**
+   * telemetry_interval is the time between the telemetry samples; zero only writes them on
+   * SIGUSR1 and at the end.
+   */
+  std::chrono::milliseconds telemetry_interval{1000};
+  /**
+   * telemetry_path is the file where the telemetry is written, or standard error if it is empty.
+   */
+  std::string telemetry_path;
+  /**
+   * heuristic_name is saved in the checkpoints, so they are only resumed with the same heuristic.
+   * A pattern database is named by its fingerprint, so it must also be the same database.
+   */
+  std::string heuristic_name;
+  /**
+   * admissible is true when the heuristic never overestimates, so the solutions of the optimal
+   * searches can be cached.
+   */
+  bool admissible = true;
+  /**
+   * checkpoint_path is the file where the search is saved, or empty to not save it.
+   */
+  std::string checkpoint_path;
+  std::chrono::seconds checkpoint_interval{600};
+  /**
+   * resume starts the search from the checkpoint in checkpoint_path instead of initial_board.
+   */
+  bool resume = false;
+  /**
+   * anytime runs the ARA* instead of the search of the build variant, from initial_weight
+   * lowering it by weight_step.
+   */
+  bool anytime = false;
+  double initial_weight = 3;
+  double weight_step = 0.5;
+  /**
+   * partial_expansion runs the EPEA* instead of the search of the build variant.
+   */
+  bool partial_expansion = false;
+  /**
+   * cache_path is the file of the solution cache, or empty to not use it. A new cache has
+   * cache_slots slots.
+   */
+  std::string cache_path;
+  uint64_t cache_slots = uint64_t{1} << 16;
+};
+
+/**
+ * cache_solution stores a solution that the search proved optimal in the cache, if there is
+ * one.
+ */
+void cache_solution(solution_cache *cache, Board b, const std::vector<Direction> &moves) {
+  if (cache != nullptr && !cache->insert(b, moves))
+    std::cerr << "The solution cache is full (" << cache->size() << " boards); the solution is not stored" << std::endl;
 }
 
-#if (defined CLEAN_MEMORY) && !(defined CLEAM_MEMORY_LOOPS)
-#define CLEAN_MEMORY_LOOPS 1000000
-#endif
+/**
+ * save_checkpoint writes the state of the A* to options.checkpoint_path.
+ *
+ * \param visited the closed set or nullptr if the search has none.
+ * \return false if the file cannot be written. errno describes the problem.
+ */
+bool save_checkpoint(const search_options &options, Board initial_board, uint64_t expanded, const search_arena &nodes, const priority_queue &queue,
+                     const closed_set *visited) {
+  checkpoint_info info{};
+  info.initial_board = initial_board;
+  info.expanded = expanded;
+  info.nodes = nodes.size();
+  info.open = queue.size();
+  info.closed = visited != nullptr ? visited->size() : 0;
+  options.heuristic_name.copy(info.heuristic, sizeof(info.heuristic) - 1);
+  info.has_closed_set = visited != nullptr;
+
+  return checkpoint::save(
+      options.checkpoint_path, info,
+      [&](uint64_t i) {
+        const search_node &n = nodes[i];
+        return checkpoint_node{n.board, n.parent, n.moves, static_cast<uint8_t>(n.direction), n.pruning_state};
+      },
+      [&](auto &&f) { queue.for_each(f); },
+      [&](auto &&f) {
+        if (visited != nullptr)
+          visited->for_each(f);
+      });
+}
 
-volatile bool sig_usr1 = false;
+/**
+ * restore_checkpoint loads the checkpoint of options.checkpoint_path in empty structures. It
+ * prints the problem when the checkpoint cannot be used.
+ *
+ * \param visited the closed set or nullptr if the search has none.
+ * \return false if the checkpoint cannot be read or was written by another search.
+ */
+bool restore_checkpoint(const search_options &options, Board &initial_board, uint64_t &expanded, search_arena &nodes, priority_queue &queue,
+                        closed_set *visited) {
+  auto c = checkpoint::open(options.checkpoint_path);
+  if (!c) {
+    std::cerr << "Cannot load the checkpoint " << options.checkpoint_path << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
 
-void sig_usr1_received(int) { sig_usr1 = true; }
+  const checkpoint_info &info = c->info();
+  if (c->heuristic() != options.heuristic_name || (info.has_closed_set != 0) != (visited != nullptr)) {
+    std::cerr << "The checkpoint " << options.checkpoint_path << " was written by another search (" << c->heuristic()
+              << (info.has_closed_set ? " with" : " without") << " closed set)" << std::endl;
+    return false;
+  }
 
-int main(int argc, const char **argv) {
-#if defined USE_VISITED || defined CLEAN_MEMORY
-  std::vector<Status> visited;
-#endif
-#if defined CLEAN_MEMORY
-  size_t clean_counter = 0;
-  priority_queue queues[2];
-  int active_queue = 0;
-  int alternative_queue = 1;
-  int removed_paths = 0;
-  std::chrono::duration<double> diff_clean;
-#define queue queues[active_queue]
-#define alter_queue queues[alternative_queue]
-#else
-  priority_queue queue;
-#endif
-  constexpr Direction directions[] = {Up, Right, Down, Left};
-  uint64_t count = 0;
-  uint64_t max = 100;
-  int percent = 0;
-  uint64_t old_count = 0;
-  int visited_inserts = 0;
-  int visited_replaced = 0;
-  struct sigaction action;
-  Board initial_board = 0x0123'4567'89ab'cdef;
+  initial_board = info.initial_board;
+  expanded = info.expanded;
+  for (uint64_t i = 0; i < info.nodes; i++) {
+    checkpoint_node n = c->node(i);
+    nodes.push_back({n.board, n.parent, n.moves, static_cast<Direction>(n.direction), n.pruning_state});
+  }
 
-  action.sa_handler = sig_usr1_received;
-  action.sa_flags = 0;
-  sigemptyset(&action.sa_mask);
+  // The entries are in the order they are popped, so they are pushed from the last one
+  for (uint64_t i = info.open; i-- > 0;) {
+    checkpoint_open_entry e = c->open_entry(i);
+    queue.push(e.f, e.g, e.node);
+  }
 
-  sigaction(SIGUSR1, &action, nullptr);
+  if (visited != nullptr)
+    for (uint64_t i = 0; i < info.closed; i++)
+      visited->insert_or_assign(c->closed_board(i), c->closed_moves(i));
 
-  using namespace std::literals;
+  return true;
+}
 
-  for (int arg = 1; arg < argc; arg++) {
-    if ("--board"sv == argv[arg]) {
-      if ((arg + 1) < argc) {
-        initial_board = std::stoull(argv[arg]);
-      } else {
-        std::cerr << "No board found" << std::endl;
-        return 1;
-      }
-    } else
-      max = std::stoull(argv[1]);
-  }
+/**
+ * a_star runs the search and prints the solution.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> int a_star(const search_options &options, const Heuristic &heuristic, solution_cache *cache) {
+#if defined USE_VISITED
+  bool visited_full_reported = false;
+#endif
+  priority_queue queue;
+  uint64_t count = 0;
+  Board initial_board = options.initial_board;
+  const uint64_t max = options.max;
+  search_arena nodes;
+#if defined USE_VISITED
+  closed_set visited(options.visited_max_bytes);
+  closed_set *const closed = &visited;
+  // The filter only knows if a board was expanded, not its moves: the first expansion of a board
+  // has its shortest path when the heuristic is consistent
+  std::optional<blocked_bloom_filter> bloom;
+  if (options.bloom_max_bytes != 0)
+    bloom.emplace(options.bloom_max_bytes);
+#else
+  closed_set *const closed = nullptr;
+#endif
 
-  if (!is_board_solvable(initial_board)) {
+  if (options.resume) {
+    if (!restore_checkpoint(options, initial_board, count, nodes, queue, closed))
+      return 1;
+    std::cerr << "Resumed from " << options.checkpoint_path << " after " << count << " iterations" << std::endl;
+  } else if (!is_board_solvable(initial_board)) {
     std::cerr << "The board cannot be solved." << std::endl;
     return 2;
   }
 
-  queue.push(status_path{Status(initial_board)});
-  auto start_time = std::chrono::system_clock::now();
-  while (!queue.top().is_solved() && !queue.empty()) {
+  std::ofstream telemetry_file;
+  if (!options.telemetry_path.empty()) {
+    telemetry_file.open(options.telemetry_path);
+    if (!telemetry_file) {
+      std::cerr << "Cannot open the telemetry file " << options.telemetry_path << std::endl;
+      return 1;
+    }
+  }
+
+  search_telemetry telemetry;
+  telemetry.expanded.set(count);
+  telemetry_sampler sampler{telemetry, options.telemetry_path.empty() ? std::cerr : telemetry_file, options.telemetry_interval};
+
+  if (!options.resume)
+    queue.push(heuristic.evaluate(initial_board), 0, nodes.push_back({initial_board, no_node, 0, Nothing, move_pruning::start}));
+  const move_pruning pruning;
+
+  background_checkpoint checkpoints;
+  const bool checkpointing = !options.checkpoint_path.empty();
+  auto next_checkpoint = std::chrono::steady_clock::now() + options.checkpoint_interval;
+  while (!queue.empty() && !nodes[queue.top()].is_solved()) {
     //        std::cout << queue << std::endl;
 
     auto top = queue.top();
+    auto top_f = queue.top_f();
     queue.pop();
+    // The arena never moves its nodes, so this reference is valid while the children are added
+    const search_node &current = nodes[top];
+
+#if defined USE_VISITED
+    if (bloom) {
+      if (bloom->insert(current.board)) {
+        telemetry.duplicates.add(1);
+        continue;
+      }
+    } else {
+      switch (visited.insert_or_improve(current.board, current.moves)) {
+      case closed_set::insert_result::inserted:
+        break;
+      case closed_set::insert_result::improved:
+        // The board was expanded with a longer path, it is expanded again: it is not a duplicate
+        break;
+      case closed_set::insert_result::not_improved:
+        // The board was already expanded with a path that is not longer
+        telemetry.duplicates.add(1);
+        continue;
+      case closed_set::insert_result::full:
+        if (!visited_full_reported) {
+          visited_full_reported = true;
+          std::cerr << "The closed set is full (" << visited.size() << " boards); new boards are not stored" << std::endl;
+        }
+        break;
+      }
+    }
+#endif
+    // Only a few expansions are timed, reading the clock costs more than expanding
+    const bool timed = telemetry.should_time();
+    const auto expansion_start = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    telemetry.record_expansion(top_f, current.moves);
+
+    // The heuristic of the children is updated from the one of the node, that is f - moves
+    const int current_md = top_f - current.moves;
+    // The legal moves of the hole position that are not pruned are one mask
+    const int hole = get_hole_position(current.board);
+    const uint8_t legal = playgroundcpp::board::legal_moves[hole];
+    const uint8_t allowed = legal & pruning.allowed(current.pruning_state);
+    telemetry.pruned.add(__builtin_popcount(legal & ~allowed));
+    for (uint8_t directions = allowed; directions != 0; directions &= directions - 1) {
+      const Direction d = static_cast<Direction>(__builtin_ctz(directions));
+      const tile_move m = playgroundcpp::board::move_hole(current.board, hole, d);
+      Status s{m.board, current.moves + 1, static_cast<uint64_t>(heuristic.update(current_md, m)), d};
 
-    if (sig_usr1) {
-      sig_usr1 = false;
-      std::cerr << top << std::endl;
+#ifdef USE_VISITED
+      // Skip visited moves if its path is longer than the stored.
+      auto moves = bloom ? nullptr : visited.find(s.board);
+      if ((moves != nullptr && s.moves > *moves) || (bloom && bloom->contains(s.board))) {
+        telemetry.duplicates.add(1);
+        continue;
+      }
+#endif
+
+      queue.push(s.moves + s.md, s.moves, nodes.push_back({s.board, top, static_cast<uint16_t>(s.moves), s.direction, pruning.next(current.pruning_state, d)}));
+      telemetry.generated.add(1);
     }
 
-#if defined USE_VISITED || defined CLEAN_MEMORY
-#if defined USE_VISITED && defined SORTED_VISITED
-    auto it = bin_search(visited.begin(), visited.end(), top.last(), [](auto const &a, auto const &b) { return a.board < b.board; });
+    telemetry.open_size.set(queue.size());
+#if defined USE_VISITED
+    telemetry.closed_size.set(bloom ? bloom->size() : visited.size());
+    telemetry.bytes.set(nodes.bytes() + (bloom ? bloom->bytes() : visited.bytes()));
 #else
-    auto it = std::find_if(visited.begin(), visited.end(), [&top](auto const &visited) { return top.path.back().board == visited.board; });
+    telemetry.bytes.set(nodes.bytes());
 #endif
-    if (it == visited.end()) {
-      // If not found, insert it
-      visited.push_back(top.last());
-#if defined USE_VISITED && defined SORTED_VISITED
-      std::sort(visited.begin(), visited.end(), [](auto const &a, auto const &b) { return a.board < b.board; });
-#endif
-      visited_inserts++;
-    } else if (it->moves > top.last().moves) {
-      // The new node is equal, but with a smaller path
-      *it = top.last();
-      visited_replaced++;
+    if (timed)
+      telemetry.record_latency(std::chrono::steady_clock::now() - expansion_start);
+
+    if (++count >= max)
+      break;
+
+    // The clock is read every 65536 iterations; the child writes the file while the search goes on.
+    // The sampler is paused, so the child does not inherit the locks it could hold while writing
+    if (checkpointing && (count & 0xffff) == 0 && std::chrono::steady_clock::now() >= next_checkpoint) {
+      auto paused = sampler.pause();
+      if (checkpoints.start([&] { return save_checkpoint(options, initial_board, count, nodes, queue, closed); }))
+        next_checkpoint = std::chrono::steady_clock::now() + options.checkpoint_interval;
     }
-#endif
-    std::vector<std::pair<std::optional<Board>, Direction>> boards(4);
-    std::transform(std::begin(directions), std::end(directions), boards.begin(), [&top](Direction d) { return std::make_pair(move(top.last().board, d), d); });
+  }
+  sampler.stop();
 
-    // Remove impossible moves
-    boards.erase(std::remove_if(boards.begin(), boards.end(), [](auto &b) { return !b.first.has_value(); }), boards.end());
+  if (checkpointing && !checkpoints.wait())
+    std::cerr << "The last checkpoint could not be written to " << options.checkpoint_path << std::endl;
 
-    std::vector<Status> new_status;
-    std::transform(boards.begin(), boards.end(), std::back_inserter(new_status), [&top](auto &b) { return Status{*b.first, top.moves() + 1, b.second}; });
+  // A search stopped before finding the solution is saved, so it can be resumed with a bigger limit
+  if (checkpointing && !queue.empty() && !nodes[queue.top()].is_solved()) {
+    if (save_checkpoint(options, initial_board, count, nodes, queue, closed))
+      std::cout << "Checkpoint: " << options.checkpoint_path << std::endl;
+    else
+      std::cerr << "Cannot write the checkpoint " << options.checkpoint_path << ": " << std::strerror(errno) << std::endl;
+  }
 
+  std::cout << "Iterations: " << count << std::endl;
+  std::cout << "Queue size: " << queue.size() << std::endl;
+  std::cout << "Nodes     : " << nodes.size() << " (" << nodes.bytes() << " bytes)" << std::endl;
 #ifdef USE_VISITED
-    // Remove visied moves if its path is longer than the stored.
-    new_status.erase(std::remove_if(new_status.begin(), new_status.end(),
-                                    [&visited](const Status &s) {
-#ifdef SORTED_VISITED
-                                      auto it = bin_search(visited.begin(), visited.end(), s, [](auto const &a, auto const &b) { return a.board < b.board; });
-#else
-            auto it = std::find_if(visited.begin(), visited.end(), [s](const Status& v){
-                return s.board == v.board;
-            });
-#endif
-                                      return it != visited.end() && s.moves > it->moves;
-                                    }),
-                     new_status.end());
+  if (bloom)
+    std::cout << "Visited   : " << bloom->size() << " (" << bloom->bytes() << " bytes, Bloom filter; expected false positive rate = " << bloom->false_positive_rate()
+              << ")" << std::endl;
+  else
+    std::cout << "Visited   : " << visited.size() << " (" << visited.bytes() << " bytes)" << std::endl;
 #endif
 
-    auto &q = queue;
-    std::for_each(new_status.begin(), new_status.end(), [&q, &top](auto &s) {
-      if (top.path.end() == std::find_if(top.path.begin(), top.path.end(), [&s](auto const &s2) { return s.board == s2.board; })) {
-        q.push(top + s);
-      }
-    });
+  if (queue.empty()) {
+    std::cout << "There isn't solution" << std::endl;
+  } else if (!nodes[queue.top()].is_solved()) {
+    std::cout << "There isn't solution" << std::endl;
+    std::cout << "Best found until now is " << rebuild_path(nodes, queue.top(), heuristic) << std::endl;
+  } else {
+    auto path = rebuild_path(nodes, queue.top(), heuristic);
+    std::cout << "Solution: " << path << std::endl;
+
+    // A false positive of the Bloom filter can prune the optimal path
+    if (options.admissible && options.bloom_max_bytes == 0) {
+      std::vector<Direction> moves;
+      for (std::size_t i = 1; i < path.path.size(); i++)
+        moves.push_back(path.path[i].direction);
+      cache_solution(cache, initial_board, moves);
+    }
+  }
 
-    if (++count == max)
-      break;
+  return 0;
+}
 
-#ifdef CLEAN_MEMORY
-    decltype(std::chrono::system_clock::now()) start_clean_time;
-    decltype(std::chrono::system_clock::now()) stop_clean_time;
-    if (++clean_counter >= CLEAN_MEMORY_LOOPS) {
-      start_clean_time = std::chrono::system_clock::now();
-      constexpr auto cmp = [](auto const &a, auto const &b) { return a.board < b.board; };
-      std::sort(visited.begin(), visited.end(), cmp);
-      while (!queue.empty()) {
-        auto path = queue.top();
-        bool insert = true;
-
-        for (auto status : path.path) {
-          auto it = bin_search(visited.begin(), visited.end(), status, cmp);
-          if (it != visited.end() && status.moves > it->moves) {
-            insert = false;
-            break;
-          }
-        }
+/**
+ * bounded_a_star runs the memory-bounded search and prints the solution. All its memory is
+ * allocated at the beginning and the worst leaves are forgotten when it is full, so it never
+ * goes over options.memory_max_bytes.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> int bounded_a_star(const search_options &options, const Heuristic &heuristic) {
+  if (!is_board_solvable(options.initial_board)) {
+    std::cerr << "The board cannot be solved." << std::endl;
+    return 2;
+  }
 
-        if (insert)
-          alter_queue.push(path);
-        else
-          removed_paths++;
+  sma_star<Heuristic> sma{heuristic, options.memory_max_bytes};
+  auto start_time = std::chrono::system_clock::now();
+  auto result = sma.solve(options.initial_board, options.max);
+  std::chrono::duration<double> diff = std::chrono::system_clock::now() - start_time;
 
-        queue.pop();
-      }
-      active_queue = (active_queue + 1) % 2;
-      alternative_queue = (active_queue + 1) % 2;
-      clean_counter = 0;
-      stop_clean_time = std::chrono::system_clock::now();
-      diff_clean += stop_clean_time - start_clean_time;
-    }
-#endif
+  std::cout << "Iterations: " << result.expanded << std::endl;
+  std::cout << "Pruned    : " << sma.pruned() << std::endl;
+  std::cout << "Nodes     : " << sma.capacity() << " (" << sma.bytes() << " bytes)" << std::endl;
+  std::cout << "Duration  : " << diff.count() << "; " << std::setprecision(10) << result.expanded / diff.count() << " counts / s" << std::endl;
+
+  if (!result.solved) {
+    std::cout << "There isn't solution" << std::endl;
+    return 0;
+  }
+
+  std::cout << "Solution: " << path_of(options.initial_board, result.moves, heuristic) << std::endl;
+
+  return 0;
+}
+
+/**
+ * anytime_a_star runs the ARA* and prints every better solution it finds, with its weight and
+ * its bound, as soon as it is found. The last one is printed again as the solution.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> int anytime_a_star(const search_options &options, const Heuristic &heuristic, solution_cache *cache) {
+  if (!is_board_solvable(options.initial_board)) {
+    std::cerr << "The board cannot be solved." << std::endl;
+    return 2;
+  }
+
+  ara_star<Heuristic> ara{heuristic, options.initial_weight, options.weight_step};
+  auto start_time = std::chrono::steady_clock::now();
+  // The solution is only optimal if its bound is 1
+  double last_bound = std::numeric_limits<double>::infinity();
+  auto result = ara.solve(options.initial_board, options.max, [&](const ara_solution &solution) {
+    last_bound = solution.bound;
+    std::chrono::duration<double, std::milli> diff = std::chrono::steady_clock::now() - start_time;
+    std::cout << "Improved  : " << solution.moves.size() << " moves; weight = " << solution.weight << "; bound = " << solution.bound
+              << "; iterations = " << solution.expanded << "; duration = " << diff.count() << " ms" << std::endl;
+  });
+
+  std::cout << "Iterations: " << result.expanded << std::endl;
+  std::cout << "Nodes     : " << ara.nodes() << " (" << ara.bytes() << " bytes)" << std::endl;
+
+  if (!result.solved) {
+    std::cout << "There isn't solution" << std::endl;
+    return 0;
+  }
+
+  std::cout << "Solution: " << path_of(options.initial_board, result.moves, heuristic) << std::endl;
+  if (options.admissible && last_bound <= 1)
+    cache_solution(cache, options.initial_board, result.moves);
+
+  return 0;
+}
+
+/**
+ * partial_expansion_a_star runs the EPEA* and prints the solution.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> int partial_expansion_a_star(const search_options &options, const Heuristic &heuristic, solution_cache *cache) {
+  if (!is_board_solvable(options.initial_board)) {
+    std::cerr << "The board cannot be solved." << std::endl;
+    return 2;
+  }
+
+  epea_star<Heuristic> epea{heuristic};
+  auto start_time = std::chrono::system_clock::now();
+  auto result = epea.solve(options.initial_board, options.max);
+  std::chrono::duration<double> diff = std::chrono::system_clock::now() - start_time;
+
+  std::cout << "Iterations: " << result.expanded << std::endl;
+  std::cout << "Reinserted: " << epea.reinserted() << std::endl;
+  std::cout << "Queue size: " << epea.max_open() << " (maximum)" << std::endl;
+  std::cout << "Nodes     : " << epea.nodes() << " (" << epea.bytes() << " bytes)" << std::endl;
+  std::cout << "Duration  : " << diff.count() << "; " << std::setprecision(10) << result.expanded / diff.count() << " counts / s" << std::endl;
+
+  if (!result.solved) {
+    std::cout << "There isn't solution" << std::endl;
+    return 0;
+  }
+
+  std::cout << "Solution: " << path_of(options.initial_board, result.moves, heuristic) << std::endl;
+  if (options.admissible)
+    cache_solution(cache, options.initial_board, result.moves);
+
+  return 0;
+}
+
+/**
+ * run_search runs the anytime or the partial expansion search if one was asked, or the search of the build variant: the memory-bounded one in 15puzzle_clean
+ * and the A* in the others.
+ */
+template <class Heuristic> int run_search(const search_options &options, const Heuristic &heuristic, solution_cache *cache) {
+  if (options.anytime)
+    return anytime_a_star(options, heuristic, cache);
+  if (options.partial_expansion)
+    return partial_expansion_a_star(options, heuristic, cache);
 
-    int new_percent = (count * 100) / max;
-    if (new_percent != percent) {
-      auto t = std::chrono::system_clock::now();
-      std::chrono::duration<double> diff = t - start_time;
-      std::cout << "count = " << count << "; duration = " << diff.count() << "; percent = " << new_percent << " %"
-                << "; visited_inserts = " << visited_inserts << "; visited_replaced = " << visited_replaced
-#ifdef CLEAN_MEMORY
-                << "; clean duration = " << diff_clean.count() << "; removed paths = " << removed_paths
-#endif
-                << "; " << std::setprecision(10) << (count - old_count) / diff.count() << " counts / s" << std::endl;
-      start_time = t;
-      old_count = count;
-      percent = new_percent;
-      visited_inserts = 0;
-      visited_replaced = 0;
 #ifdef CLEAN_MEMORY
-      removed_paths = 0;
-      diff_clean = decltype(diff_clean){};
+  if (!options.checkpoint_path.empty()) {
+    std::cerr << "The memory-bounded search has no checkpoints" << std::endl;
+    return 1;
+  }
+  // Its solutions are not cached: a wrong one would be given to every later process, and the
+  // forgetting of the memory-bounded search is not proven to keep them optimal
+  return bounded_a_star(options, heuristic);
+#else
+  return a_star(options, heuristic, cache);
 #endif
+}
+
+/**
+ * search looks for the board in the solution cache and runs the search if it is not there. The
+ * optimal solutions found are added to the cache.
+ */
+template <class Heuristic> int search(const search_options &options, const Heuristic &heuristic) {
+  std::optional<solution_cache> cache;
+  if (!options.cache_path.empty()) {
+    cache = solution_cache::open(options.cache_path, options.cache_slots);
+    if (!cache) {
+      std::cerr << "Cannot open the solution cache " << options.cache_path << ": " << std::strerror(errno) << std::endl;
+      return 1;
+    }
+
+    // The board of a resumed search is in the checkpoint
+    if (!options.resume) {
+      if (auto moves = cache->find(options.initial_board)) {
+        std::cout << "Cached    : " << cache->size() << " boards in " << options.cache_path << std::endl;
+        std::cout << "Solution: " << path_of(options.initial_board, *moves, heuristic) << std::endl;
+        return 0;
+      }
     }
   }
 
-  std::cout << "Iterations: " << count << std::endl;
-  std::cout << "Queue size: " << queue.size() << std::endl;
-#ifdef USE_VISITED
-  std::cout << "Visited   : " << visited.size() << std::endl;
+  return run_search(options, heuristic, cache ? &*cache : nullptr);
+}
+
+int main(int argc, const char **argv) {
+  search_options options;
+  std::optional<pattern_database> pdb;
+  std::string_view heuristic_name = "manhattan";
+  struct sigaction action;
+
+  action.sa_handler = request_telemetry_dump;
+  action.sa_flags = 0;
+  sigemptyset(&action.sa_mask);
+
+  sigaction(SIGUSR1, &action, nullptr);
+
+  using namespace std::literals;
+
+  for (int arg = 1; arg < argc; arg++) {
+    if ("--board"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        auto board = parse_board(argv[++arg]);
+        if (!board) {
+          std::cerr << "Invalid board " << argv[arg] << std::endl;
+          return 1;
+        }
+        options.initial_board = *board;
+      } else {
+        std::cerr << "No board found" << std::endl;
+        return 1;
+      }
+    } else if ("--closed-set-mib"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.visited_max_bytes = std::stoull(argv[++arg]) << 20;
+      } else {
+        std::cerr << "No closed set size found" << std::endl;
+        return 1;
+      }
+    } else if ("--bloom-mib"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.bloom_max_bytes = std::stoull(argv[++arg]) << 20;
+      } else {
+        std::cerr << "No Bloom filter size found" << std::endl;
+        return 1;
+      }
+    } else if ("--memory-mib"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.memory_max_bytes = std::stoull(argv[++arg]) << 20;
+      } else {
+        std::cerr << "No memory size found" << std::endl;
+        return 1;
+      }
+    } else if ("--telemetry-interval"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.telemetry_interval = std::chrono::milliseconds{std::stoull(argv[++arg])};
+      } else {
+        std::cerr << "No telemetry interval found" << std::endl;
+        return 1;
+      }
+    } else if ("--telemetry-file"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.telemetry_path = argv[++arg];
+      } else {
+        std::cerr << "No telemetry file found" << std::endl;
+        return 1;
+      }
+    } else if ("--checkpoint"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.checkpoint_path = argv[++arg];
+      } else {
+        std::cerr << "No checkpoint file found" << std::endl;
+        return 1;
+      }
+    } else if ("--checkpoint-interval"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.checkpoint_interval = std::chrono::seconds{std::stoull(argv[++arg])};
+      } else {
+        std::cerr << "No checkpoint interval found" << std::endl;
+        return 1;
+      }
+    } else if ("--cache"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.cache_path = argv[++arg];
+      } else {
+        std::cerr << "No cache file found" << std::endl;
+        return 1;
+      }
+    } else if ("--cache-slots"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.cache_slots = std::stoull(argv[++arg]);
+      } else {
+        std::cerr << "No cache size found" << std::endl;
+        return 1;
+      }
+    } else if ("--resume"sv == argv[arg]) {
+      options.resume = true;
+    } else if ("--anytime"sv == argv[arg]) {
+      options.anytime = true;
+    } else if ("--partial-expansion"sv == argv[arg]) {
+      options.partial_expansion = true;
+    } else if ("--weight"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.initial_weight = std::stod(argv[++arg]);
+      } else {
+        std::cerr << "No weight found" << std::endl;
+        return 1;
+      }
+    } else if ("--weight-step"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.weight_step = std::stod(argv[++arg]);
+      } else {
+        std::cerr << "No weight step found" << std::endl;
+        return 1;
+      }
+    } else if ("--heuristic"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        heuristic_name = argv[++arg];
+      } else {
+        std::cerr << "No heuristic found" << std::endl;
+        return 1;
+      }
+    } else if ("--pdb"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        pdb = pattern_database::open(argv[++arg]);
+        if (!pdb) {
+          std::cerr << "Cannot load the pattern database " << argv[arg] << ": " << std::strerror(errno) << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No pattern database found" << std::endl;
+        return 1;
+      }
+    } else
+      options.max = std::stoull(argv[arg]);
+  }
+
+#ifndef USE_VISITED
+  if (options.bloom_max_bytes != 0) {
+    std::cerr << "Only the searches with a closed set can use a Bloom filter" << std::endl;
+    return 1;
+  }
 #endif
+  if (options.bloom_max_bytes != 0 && !options.checkpoint_path.empty()) {
+    std::cerr << "The checkpoints need the exact closed set, not a Bloom filter" << std::endl;
+    return 1;
+  }
+  if (options.bloom_max_bytes != 0 && (options.anytime || options.partial_expansion)) {
+    std::cerr << "Only the A* can use a Bloom filter, not the anytime nor the partial expansion searches" << std::endl;
+    return 1;
+  }
 
-  if (queue.empty() || !queue.top().is_solved()) {
-    std::cout << "There isn't solution" << std::endl;
-    std::cout << "Best found until now is " << queue.top() << std::endl;
-  } else {
-    std::cout << "Solution: " << queue.top() << std::endl;
+  if (options.resume && options.checkpoint_path.empty()) {
+    std::cerr << "No checkpoint file found" << std::endl;
+    return 1;
   }
 
-  return 0;
+  options.heuristic_name = pdb ? "pdb-" + std::to_string(pdb->fingerprint()) : std::string{heuristic_name};
+  options.admissible = pdb || heuristic_name != "squared-manhattan"sv;
+  if (pdb)
+    return search(options, *pdb);
+
+  // The squared distances are not admissible, they are only used when they are asked for
+  if (heuristic_name == "squared-manhattan"sv)
+    return search(options, squared_manhattan_heuristic{});
+
+  if (auto status = with_heuristic(heuristic_name, [&](const auto &heuristic) { return search(options, heuristic); }))
+    return *status;
+
+  std::cerr << "Unknown heuristic " << heuristic_name << std::endl;
+  return 1;
 }
+
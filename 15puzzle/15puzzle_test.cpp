@@ -0,0 +1,1124 @@
+#include "ara.hpp"
+#include "bidirectional.hpp"
+#include "bloom_filter.hpp"
+#include "board.hpp"
+#include "bucket_queue.hpp"
+#include "checkpoint.hpp"
+#include "closed_set.hpp"
+#include "epea.hpp"
+#include "external_search.hpp"
+#include "hda.hpp"
+#include "heuristic.hpp"
+#include "ida.hpp"
+#include "layered_bfs.hpp"
+#include "move_pruning.hpp"
+#include "pattern_database.hpp"
+#include "node_arena.hpp"
+#include "parallel_ida.hpp"
+#include "radix_sort.hpp"
+#include "sliding_heuristic.hpp"
+#include "sliding_ida.hpp"
+#include "sliding_puzzle.hpp"
+#include "sma.hpp"
+#include "solution_cache.hpp"
+#include "solver_protocol.hpp"
+#include "telemetry.hpp"
+#include "unix_socket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+
+/**
+ * applies the moves to the board. It returns 0 if a move is not possible.
+ */
+Board apply_moves(Board b, const std::vector<Direction> &moves) {
+  for (auto d : moves) {
+    auto next = move(b, d);
+    if (!next)
+      return 0;
+    b = *next;
+  }
+  return b;
+}
+
+/**
+ * walks randomly from the board checking that the updated value of the heuristic is the evaluated one.
+ */
+template <class Heuristic> void check_update(const Heuristic &h, Board b, int steps) {
+  int value = h.evaluate(b);
+  uint32_t seed = 12345;
+  for (int i = 0; i < steps; i++) {
+    seed = seed * 1103515245 + 12345;
+    auto m = move_tile(b, directions[(seed >> 16) % 4]);
+    if (!m)
+      continue;
+    value = h.update(value, *m);
+    b = m->board;
+    ASSERT_EQ(value, h.evaluate(b));
+  }
+}
+
+TEST(node_arena_test, handles_are_consecutive) {
+  node_arena<uint64_t, 2> arena;
+  for (uint64_t i = 0; i < 10; i++)
+    ASSERT_EQ(arena.push_back(i * 3), i);
+
+  ASSERT_EQ(arena.size(), 10);
+  for (node_handle h = 0; h < 10; h++)
+    ASSERT_EQ(arena[h], h * 3);
+}
+
+TEST(node_arena_test, nodes_are_not_moved_when_growing) {
+  node_arena<uint64_t, 2> arena;
+  arena.push_back(42);
+  const uint64_t *first = &arena[0];
+
+  for (uint64_t i = 0; i < 100; i++)
+    arena.push_back(i);
+
+  ASSERT_EQ(first, &arena[0]);
+  ASSERT_EQ(*first, 42);
+  ASSERT_EQ(arena.bytes(), 26 * 4 * sizeof(uint64_t));
+}
+
+TEST(node_arena_test, clear) {
+  node_arena<uint64_t, 2> arena;
+  arena.push_back(1);
+  arena.clear();
+  ASSERT_EQ(arena.size(), 0);
+  ASSERT_EQ(arena.bytes(), 0);
+  ASSERT_EQ(arena.push_back(2), 0);
+}
+
+TEST(closed_set_test, insert_and_find) {
+  closed_set set;
+  ASSERT_EQ(set.find(0x1234'5678'9abc'def0), nullptr);
+  ASSERT_EQ(set.insert_or_improve(0x1234'5678'9abc'def0, 10), closed_set::insert_result::inserted);
+  ASSERT_NE(set.find(0x1234'5678'9abc'def0), nullptr);
+  ASSERT_EQ(*set.find(0x1234'5678'9abc'def0), 10);
+  ASSERT_EQ(set.size(), 1);
+}
+
+TEST(closed_set_test, keeps_the_best_value) {
+  closed_set set;
+  set.insert_or_improve(0x1234'5678'9abc'def0, 10);
+  ASSERT_EQ(set.insert_or_improve(0x1234'5678'9abc'def0, 12), closed_set::insert_result::not_improved);
+  ASSERT_EQ(*set.find(0x1234'5678'9abc'def0), 10);
+  ASSERT_EQ(set.insert_or_improve(0x1234'5678'9abc'def0, 8), closed_set::insert_result::improved);
+  ASSERT_EQ(*set.find(0x1234'5678'9abc'def0), 8);
+  ASSERT_EQ(set.insert_or_assign(0x1234'5678'9abc'def0, 9), closed_set::insert_result::improved);
+  ASSERT_EQ(*set.find(0x1234'5678'9abc'def0), 9);
+}
+
+TEST(closed_set_test, grows_keeping_the_elements) {
+  closed_set set(std::numeric_limits<std::size_t>::max(), 8);
+  for (uint64_t i = 1; i <= 100000; i++)
+    ASSERT_EQ(set.insert_or_improve(i * 0x1'0000'0001ull, i & 0xffff), closed_set::insert_result::inserted);
+
+  ASSERT_EQ(set.size(), 100000);
+  ASSERT_LE(set.load_factor(), 7.0 / 8.0);
+  for (uint64_t i = 1; i <= 100000; i++) {
+    auto v = set.find(i * 0x1'0000'0001ull);
+    ASSERT_NE(v, nullptr);
+    ASSERT_EQ(*v, i & 0xffff);
+  }
+  ASSERT_EQ(set.find(0xffff'ffff'ffff'ffffull), nullptr);
+}
+
+TEST(closed_set_test, respects_the_memory_cap) {
+  closed_set set(64 * closed_set::bytes_per_slot, 8);
+  std::size_t inserted = 0;
+  for (uint64_t i = 1; i <= 1000; i++)
+    if (set.insert_or_improve(i, 1) == closed_set::insert_result::inserted)
+      inserted++;
+
+  ASSERT_EQ(set.capacity(), 64);
+  ASSERT_LE(set.bytes(), 64 * closed_set::bytes_per_slot);
+  ASSERT_EQ(inserted, 60);
+  ASSERT_EQ(set.insert_or_improve(1000, 1), closed_set::insert_result::full);
+  ASSERT_EQ(set.insert_or_improve(1, 0), closed_set::insert_result::improved);
+}
+
+TEST(bucket_queue_test, pops_by_f_then_deeper_then_last) {
+  bucket_queue<int> q;
+  q.push(5, 1, 1);
+  q.push(3, 1, 2);
+  q.push(3, 2, 3);
+  q.push(3, 2, 4);
+  q.push(7, 0, 5);
+  ASSERT_EQ(q.size(), 5);
+
+  std::vector<int> order;
+  q.for_each([&order](uint32_t, uint32_t, int v) { order.push_back(v); });
+  ASSERT_EQ(order, (std::vector<int>{4, 3, 2, 1, 5}));
+  ASSERT_EQ(q.size(), 5);
+
+  std::vector<int> popped;
+  while (!q.empty()) {
+    popped.push_back(q.top());
+    q.pop();
+  }
+  ASSERT_EQ(popped, order);
+}
+
+TEST(bucket_queue_test, smaller_f_after_pop) {
+  bucket_queue<int> q;
+  q.push(4, 0, 1);
+  q.push(6, 1, 2);
+  q.pop();
+  ASSERT_EQ(q.top_f(), 6);
+  q.push(2, 3, 3);
+  ASSERT_EQ(q.top(), 3);
+  ASSERT_EQ(q.top_f(), 2);
+  ASSERT_EQ(q.top_g(), 3);
+  q.pop();
+  ASSERT_EQ(q.top(), 2);
+  q.clear();
+  ASSERT_TRUE(q.empty());
+}
+
+TEST(board_test, solvable) {
+  ASSERT_TRUE(is_board_solvable(solved_board));
+  ASSERT_TRUE(is_board_solvable(0xd2a3'1c84'5096'feb7));
+  ASSERT_TRUE(is_board_solvable(0x5123'9674'0ab8'defc));
+  ASSERT_FALSE(is_board_solvable(0x391f'eb46'd0ac'2785));
+  ASSERT_FALSE(is_board_solvable(0x0123'4567'89ab'cdef));
+  ASSERT_FALSE(is_board_solvable(0x1234'5678'9abc'dfe0));
+}
+
+TEST(board_test, inversions) {
+  ASSERT_EQ(count_board_inversions(solved_board), 0);
+  ASSERT_EQ(count_board_inversions(0xd2a3'1c84'5096'feb7), 41);
+  ASSERT_EQ(count_board_inversions(0x391f'eb46'd0ac'2785), 56);
+}
+
+TEST(board_test, parse_board) {
+  ASSERT_EQ(parse_board("123456789abcdef0"), solved_board);
+  ASSERT_EQ(parse_board("0x1234'5678'9ABC'DEF0"), solved_board);
+  ASSERT_FALSE(parse_board("123456789abcdef").has_value());
+  ASSERT_FALSE(parse_board("123456789abcdef00").has_value());
+  ASSERT_FALSE(parse_board("113456789abcdef0").has_value());
+  ASSERT_FALSE(parse_board("12345678 9abcdef0").has_value());
+}
+
+TEST(board_test, parse_tiles) {
+  ASSERT_EQ(parse_tiles("1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 0"), solved_board);
+  ASSERT_EQ(parse_tiles("13, 2, 10, 3, 1, 12, 8, 4, 5, 0, 9, 6, 15, 14, 11, 7"), 0xd2a3'1c84'5096'feb7);
+  ASSERT_FALSE(parse_tiles("1 2 3 4 5 6 7 8 9 10 11 12 13 14 15").has_value());
+  ASSERT_FALSE(parse_tiles("1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 0 0").has_value());
+  ASSERT_FALSE(parse_tiles("1 2 3 4 5 6 7 8 9 10 11 12 13 14 16 0").has_value());
+  ASSERT_FALSE(parse_tiles("1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 0x").has_value());
+}
+
+TEST(board_test, move_tile) {
+  auto m = move_tile(solved_board, Up);
+  ASSERT_TRUE(m.has_value());
+  ASSERT_EQ(m->board, 0x1234'5678'9ab0'defc);
+  ASSERT_EQ(m->tile, 0xc);
+  ASSERT_EQ(m->from, 4);
+  ASSERT_EQ(m->to, 0);
+
+  m = move_tile(solved_board, Left);
+  ASSERT_TRUE(m.has_value());
+  ASSERT_EQ(m->board, 0x1234'5678'9abc'de0f);
+  ASSERT_EQ(m->tile, 0xf);
+  ASSERT_EQ(m->from, 1);
+  ASSERT_EQ(m->to, 0);
+
+  ASSERT_FALSE(move_tile(solved_board, Down).has_value());
+  ASSERT_FALSE(move_tile(solved_board, Right).has_value());
+}
+
+TEST(board_test, transpose) {
+  ASSERT_EQ(transpose(solved_board), solved_board);
+  // The hole moved left is the hole moved up
+  ASSERT_EQ(transpose(0x1234'5678'9abc'de0f), 0x1234'5678'9ab0'defc);
+  ASSERT_EQ(transpose(0x1234'5678'9abc'0def), 0x1230'5674'9ab8'defc);
+  ASSERT_EQ(transpose(Up), Left);
+  ASSERT_EQ(transpose(Right), Down);
+  ASSERT_EQ(transpose(Nothing), Nothing);
+
+  // The transposed moves do the same to the transposed board
+  std::mt19937_64 random{24};
+  Board b = solved_board;
+  for (int i = 0; i < 1000; i++) {
+    const Board t = transpose(b);
+    ASSERT_EQ(transpose(t), b);
+    ASSERT_EQ(is_board_solvable(t), is_board_solvable(b));
+    Direction d = directions[random() % 4];
+    auto next = move(b, d);
+    ASSERT_EQ(next.has_value(), move(t, transpose(d)).has_value());
+    if (next) {
+      ASSERT_EQ(*move(t, transpose(d)), transpose(*next));
+      b = *next;
+    }
+  }
+}
+
+TEST(heuristic_test, manhattan) {
+  manhattan_heuristic h;
+  ASSERT_EQ(h.evaluate(solved_board), 0);
+  ASSERT_EQ(h.evaluate(0x1234'5678'9abc'de0f), 1);
+  ASSERT_EQ(h.evaluate(0x1234'5678'9ab0'defc), 1);
+  ASSERT_EQ(h.evaluate(0x1234'5670'9ab8'defc), 2);
+  ASSERT_EQ(h.evaluate(0x1234'5607'9ab8'defc), 3);
+}
+
+TEST(heuristic_test, manhattan_update) { check_update(manhattan_heuristic{}, solved_board, 1000); }
+
+TEST(heuristic_test, manhattan_to) {
+  manhattan_to_heuristic to_solved{solved_board};
+  manhattan_heuristic manhattan;
+  for (Board b : {0x5123'9674'0ab8'defcull, 0xd2a3'1c84'5096'feb7ull})
+    ASSERT_EQ(to_solved.evaluate(b), manhattan.evaluate(b));
+
+  manhattan_to_heuristic to_board{0xd2a3'1c84'5096'feb7};
+  ASSERT_EQ(to_board.evaluate(0xd2a3'1c84'5096'feb7), 0);
+  ASSERT_EQ(to_board.evaluate(solved_board), manhattan.evaluate(0xd2a3'1c84'5096'feb7));
+  check_update(to_board, solved_board, 1000);
+}
+
+TEST(heuristic_test, linear_conflict) {
+  linear_conflict_heuristic h;
+  ASSERT_EQ(h.evaluate(solved_board), 0);
+  ASSERT_EQ(h.evaluate(0x1234'5678'9abc'de0f), 1);
+  // 13 and 14 are in their row but swapped, and so are 4 and 8 in their column
+  ASSERT_EQ(h.evaluate(0x1234'5678'9abc'edf0), 4);
+  ASSERT_EQ(h.evaluate(0x1238'5674'9abc'def0), 4);
+  // 1, 2 and 3 are reversed: two of them must leave the row
+  ASSERT_EQ(h.evaluate(0x3214'5678'9abc'def0), 8);
+
+  manhattan_heuristic manhattan;
+  for (Board b : {0x5123'9674'0ab8'defcull, 0xd2a3'1c84'5096'feb7ull, 0x0fed'cba9'8765'4321ull})
+    ASSERT_GE(h.evaluate(b), manhattan.evaluate(b));
+  check_update(h, solved_board, 1000);
+}
+
+TEST(heuristic_test, walking_distance) {
+  walking_distance_heuristic h;
+  ASSERT_EQ(h.evaluate(solved_board), 0);
+  ASSERT_EQ(h.evaluate(0x1234'5678'9abc'de0f), 1);
+  ASSERT_EQ(h.evaluate(0x1234'5678'9ab0'defc), 1);
+  ASSERT_EQ(h.evaluate(0x1234'5670'9ab8'defc), 2);
+  check_update(h, solved_board, 1000);
+}
+
+TEST(heuristic_test, admissible_heuristics_solve_optimally) {
+  for (std::string_view name : {"manhattan", "linear-conflict", "walking-distance"}) {
+    auto moves = with_heuristic(name, [](const auto &h) {
+      ida_star<std::decay_t<decltype(h)>> ida{h};
+      auto result = ida.solve(0xd2a3'1c84'5096'feb7);
+      EXPECT_EQ(apply_moves(0xd2a3'1c84'5096'feb7, result.moves), solved_board);
+      EXPECT_LE(h.evaluate(0xd2a3'1c84'5096'feb7), 41);
+      return result.moves.size();
+    });
+    ASSERT_EQ(moves, 41u) << name;
+  }
+  ASSERT_FALSE(with_heuristic("squared-manhattan", [](const auto &) { return 0; }).has_value());
+}
+
+/**
+ * checks that a solver finds the optimal solutions of the reference boards, from the solved one
+ * to one of 42 moves that needs several iterations or forgetting nodes, and that it fails on an
+ * unsolvable board and at the limit of expanded nodes.
+ *
+ * \param solve calls the solver with a board and the limit of expanded nodes.
+ */
+template <class Solve> void expect_solves_reference_boards(Solve &&solve) {
+  struct reference {
+    Board board;
+    std::size_t moves;
+  };
+  for (auto [board, moves] : {reference{solved_board, 0}, {0x5123'9674'0ab8'defc, 8}, {0xd2a3'1c84'5096'feb7, 41}, {0xa568'9310'7b24'dfce, 42}}) {
+    SCOPED_TRACE(testing::Message() << std::hex << board);
+    search_result result = solve(board, std::numeric_limits<uint64_t>::max());
+    EXPECT_TRUE(result.solved);
+    EXPECT_EQ(result.moves.size(), moves);
+    EXPECT_EQ(apply_moves(board, result.moves), solved_board);
+  }
+
+  EXPECT_FALSE(solve(0x0123'4567'89ab'cdef, std::numeric_limits<uint64_t>::max()).solved);
+  search_result limited = solve(0xd2a3'1c84'5096'feb7, 1000);
+  EXPECT_FALSE(limited.solved);
+  EXPECT_GE(limited.expanded, 1000u);
+}
+
+TEST(ida_test, solves_optimally) {
+  manhattan_heuristic h;
+  ida_star<manhattan_heuristic> ida{h};
+  expect_solves_reference_boards([&](Board b, uint64_t max_nodes) { return ida.solve(b, max_nodes); });
+
+  // The limit is checked at every expansion
+  ASSERT_EQ(ida.solve(0xd2a3'1c84'5096'feb7, 1000).expanded, 1000);
+}
+
+TEST(ida_test, should_stop_ends_the_search) {
+  manhattan_heuristic h;
+  ida_star<manhattan_heuristic> ida{h};
+  int checks = 0;
+  auto result = ida.solve(0xd2a3'1c84'5096'feb7, ida.unlimited, [](int, uint64_t) {}, [&] { return ++checks == 3; });
+  ASSERT_FALSE(result.solved);
+  ASSERT_EQ(checks, 3);
+  ASSERT_EQ(result.expanded, 3 * ida.stop_check_interval);
+}
+
+TEST(parallel_ida_test, solves_optimally) {
+  manhattan_heuristic h;
+  for (unsigned workers : {1u, 3u}) {
+    SCOPED_TRACE(testing::Message() << workers << " workers");
+    parallel_ida_star<manhattan_heuristic> ida{h, workers};
+    expect_solves_reference_boards([&](Board b, uint64_t max_nodes) { return ida.solve(b, max_nodes); });
+  }
+}
+
+TEST(bidirectional_test, solves_optimally) {
+  manhattan_heuristic h;
+  expect_solves_reference_boards([&](Board b, uint64_t max_nodes) {
+    manhattan_to_heuristic backward{b};
+    bidirectional_search<manhattan_heuristic, manhattan_to_heuristic> search{h, backward};
+    auto result = search.solve(b, max_nodes);
+    // The meeting in the middle keeps the solutions optimal, as long as the ones of IDA*
+    if (result.solved) {
+      EXPECT_EQ(result.moves.size(), ida_star<manhattan_heuristic>{h}.solve(b).moves.size());
+    }
+    return result;
+  });
+}
+
+TEST(hda_test, solves_optimally) {
+  manhattan_heuristic h;
+  for (unsigned workers : {1u, 4u}) {
+    SCOPED_TRACE(testing::Message() << workers << " workers");
+    hda_star<manhattan_heuristic> hda{h, workers};
+    expect_solves_reference_boards([&](Board b, uint64_t max_nodes) { return hda.solve(b, max_nodes); });
+  }
+}
+
+TEST(sma_test, solves_optimally_within_the_budget) {
+  linear_conflict_heuristic h;
+  // A few thousand nodes: the solutions of 41 and 42 moves need to forget and regenerate subtrees,
+  // through parents that have forgotten some of their children, but not all
+  constexpr std::size_t budget = 256 << 10;
+  sma_star<linear_conflict_heuristic> sma{h, budget};
+  ASSERT_LE(sma.bytes(), budget);
+  uint64_t pruned = 0;
+  expect_solves_reference_boards([&](Board b, uint64_t max_nodes) {
+    auto result = sma.solve(b, max_nodes);
+    pruned += sma.pruned();
+    return result;
+  });
+  ASSERT_GT(pruned, 0u);
+}
+
+TEST(sma_test, too_small) {
+  manhattan_heuristic h;
+  // The budget does not hold the path of the solution
+  sma_star<manhattan_heuristic> tiny{h, sma_star<manhattan_heuristic>::max_f * 16 + 6 * 32};
+  ASSERT_FALSE(tiny.solve(0xd2a3'1c84'5096'feb7, 100000).solved);
+  ASSERT_FALSE(sma_star<manhattan_heuristic>(h, 0).solve(0x5123'9674'0ab8'defc).solved);
+}
+
+TEST(external_search_test, frontier_files) {
+  const std::string path = testing::TempDir() + "frontier_test.bin";
+  {
+    auto writer = frontier_writer::create(path);
+    ASSERT_TRUE(writer.has_value());
+    for (Board b : {Board{3}, Board{5}, solved_board})
+      ASSERT_TRUE(writer->write({b, static_cast<uint8_t>(b & 0xf)}));
+    ASSERT_EQ(writer->size(), 3u);
+    ASSERT_TRUE(writer->close());
+  }
+
+  auto file = frontier_file::open(path);
+  ASSERT_TRUE(file.has_value());
+  ASSERT_EQ(file->size(), 3u);
+  ASSERT_EQ((*file)[1].board, 5u);
+  ASSERT_EQ((*file)[1].used, 5u);
+  ASSERT_EQ((*file)[2].board, solved_board);
+  ASSERT_TRUE(file->contains(3));
+  ASSERT_TRUE(file->contains(solved_board));
+  ASSERT_FALSE(file->contains(4));
+  std::remove(path.c_str());
+
+  // The entries that cannot be written are not counted
+  auto full = frontier_writer::create("/dev/full");
+  ASSERT_TRUE(full.has_value());
+  uint64_t written = 0;
+  while (written <= frontier_writer::buffer_size && full->write({solved_board, 0}))
+    written++;
+  ASSERT_EQ(errno, ENOSPC);
+  ASSERT_EQ(full->size(), written);
+  ASSERT_FALSE(full->close());
+}
+
+TEST(external_search_test, solves_optimally) {
+  manhattan_heuristic h;
+  // A small buffer, so every layer is written in several runs
+  external_search<manhattan_heuristic> search{h, testing::TempDir(), 4096};
+
+  auto result = search.solve(solved_board);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_TRUE(result->solved);
+  ASSERT_TRUE(result->moves.empty());
+
+  result = search.solve(0x5123'9674'0ab8'defc);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_TRUE(result->solved);
+  ASSERT_EQ(result->moves.size(), 8);
+  ASSERT_EQ(apply_moves(0x5123'9674'0ab8'defc, result->moves), solved_board);
+
+  std::size_t max_runs = 0;
+  result = search.solve(0xd2a3'1c84'5096'feb7, external_search<manhattan_heuristic>::unlimited,
+                        [&](int, int, uint64_t, std::size_t runs) { max_runs = std::max(max_runs, runs); });
+  ASSERT_TRUE(result.has_value());
+  ASSERT_TRUE(result->solved);
+  ASSERT_EQ(result->moves.size(), 41);
+  ASSERT_EQ(apply_moves(0xd2a3'1c84'5096'feb7, result->moves), solved_board);
+  ASSERT_GT(max_runs, 1u);
+}
+
+TEST(external_search_test, unsolvable_limited_and_errors) {
+  manhattan_heuristic h;
+  external_search<manhattan_heuristic> search{h, testing::TempDir(), 1 << 20};
+  ASSERT_FALSE(search.solve(0x0123'4567'89ab'cdef)->solved);
+  ASSERT_FALSE(search.solve(0xd2a3'1c84'5096'feb7, 1000)->solved);
+
+  external_search<manhattan_heuristic> missing{h, testing::TempDir() + "does/not/exist", 1 << 20};
+  ASSERT_FALSE(missing.solve(0x5123'9674'0ab8'defc).has_value());
+}
+
+TEST(radix_sort_test, sorts_like_std_sort) {
+  for (std::size_t size : {0, 1, 1000, 300'000}) {
+    std::vector<uint64_t> values(size);
+    uint64_t seed = 42;
+    for (auto &v : values) {
+      seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+      v = seed;
+    }
+    // Some repeated values and a byte that is always the same
+    for (std::size_t i = 0; i < size; i += 7)
+      values[i] = values[i / 2];
+    for (auto &v : values)
+      v &= ~(0xffull << 24);
+
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+    for (unsigned threads : {1u, 4u}) {
+      auto sorted = values;
+      parallel_radix_sort(sorted, threads);
+      ASSERT_EQ(sorted, expected);
+    }
+  }
+}
+
+TEST(layered_bfs_test, counts_the_boards_at_each_distance) {
+  // The number of boards at each distance from the solved board (OEIS A089473)
+  const std::vector<std::size_t> expected{1, 2, 4, 10, 24, 54, 107, 212, 446, 946, 1948, 3938, 7808, 15544, 30821};
+  for (unsigned threads : {1u, 3u}) {
+    std::vector<std::size_t> sizes;
+    manhattan_heuristic h;
+    layered_bfs(solved_board, 14, threads, [&](int depth, const std::vector<uint64_t> &boards) {
+      ASSERT_EQ(static_cast<std::size_t>(depth), sizes.size());
+      ASSERT_TRUE(std::is_sorted(boards.begin(), boards.end()));
+      for (Board b : boards)
+        ASSERT_LE(h.evaluate(b), depth);
+      sizes.push_back(boards.size());
+    });
+    ASSERT_EQ(sizes, expected);
+  }
+}
+
+/**
+ * applies the moves to a board of any puzzle.
+ */
+template <class Puzzle> typename Puzzle::board_type apply_puzzle_moves(typename Puzzle::board_type b, const std::vector<Direction> &moves) {
+  for (auto d : moves) {
+    auto m = Puzzle::move(b, d);
+    if (!m)
+      return 0;
+    b = m->board;
+  }
+  return b;
+}
+
+TEST(sliding_puzzle_test, fifteen_puzzle_is_the_board) {
+  manhattan_heuristic manhattan;
+  linear_conflict_heuristic linear_conflict;
+  sliding_manhattan<fifteen_puzzle> generic_manhattan;
+  sliding_linear_conflict<fifteen_puzzle> generic_linear_conflict;
+
+  Board b = solved_board;
+  uint32_t seed = 7;
+  for (int i = 0; i < 1000; i++) {
+    for (auto d : directions) {
+      auto expected = move_tile(b, d);
+      auto m = fifteen_puzzle::move(b, d);
+      ASSERT_EQ(m.has_value(), expected.has_value());
+      if (m) {
+        ASSERT_EQ(m->board, expected->board);
+        ASSERT_EQ(m->tile, expected->tile);
+      }
+    }
+    ASSERT_EQ(fifteen_puzzle::is_solvable(b), is_board_solvable(b));
+    ASSERT_EQ(generic_manhattan.evaluate(b), manhattan.evaluate(b));
+    ASSERT_EQ(generic_linear_conflict.evaluate(b), linear_conflict.evaluate(b));
+
+    seed = seed * 1103515245 + 12345;
+    if (auto next = move(b, directions[(seed >> 16) % 4]))
+      b = *next;
+  }
+  ASSERT_EQ(fifteen_puzzle::parse("13 2 10 3 1 12 8 4 5 0 9 6 15 14 11 7"), parse_tiles("13 2 10 3 1 12 8 4 5 0 9 6 15 14 11 7"));
+}
+
+TEST(sliding_puzzle_test, eight_puzzle) {
+  auto board = eight_puzzle::parse("8 6 7, 2 5 4, 3 0 1");
+  ASSERT_TRUE(board.has_value());
+  ASSERT_EQ(eight_puzzle::to_string(*board), "8 6 7, 2 5 4, 3 0 1");
+  ASSERT_FALSE(eight_puzzle::parse("8 6 7 2 5 4 3 0 9").has_value());
+  ASSERT_FALSE(eight_puzzle::is_solvable(*eight_puzzle::parse("6 8 7 2 5 4 3 0 1")));
+
+  // One of the two hardest boards of the 8 puzzle
+  for (int i = 0; i < 2; i++) {
+    sliding_manhattan<eight_puzzle> manhattan;
+    sliding_linear_conflict<eight_puzzle> linear_conflict;
+    auto result = i == 0 ? sliding_ida_star<eight_puzzle, sliding_manhattan<eight_puzzle>>{manhattan}.solve(*board)
+                         : sliding_ida_star<eight_puzzle, sliding_linear_conflict<eight_puzzle>>{linear_conflict}.solve(*board);
+    ASSERT_TRUE(result.solved);
+    ASSERT_EQ(result.moves.size(), 31);
+    ASSERT_EQ(apply_puzzle_moves<eight_puzzle>(*board, result.moves), eight_puzzle::goal);
+  }
+}
+
+TEST(sliding_puzzle_test, twenty_four_puzzle) {
+  sliding_linear_conflict<twenty_four_puzzle> h;
+  sliding_ida_star<twenty_four_puzzle, sliding_linear_conflict<twenty_four_puzzle>> ida{h};
+
+  auto b = twenty_four_puzzle::goal;
+  int value = h.evaluate(b);
+  uint32_t seed = 3;
+  std::vector<Direction> walk;
+  while (walk.size() < 30) {
+    seed = seed * 1103515245 + 12345;
+    Direction d = directions[(seed >> 16) % 4];
+    if (!walk.empty() && d == inverse(walk.back()))
+      continue;
+    auto m = twenty_four_puzzle::move(b, d);
+    if (!m)
+      continue;
+    value = h.update(value, *m);
+    b = m->board;
+    ASSERT_EQ(value, h.evaluate(b));
+    walk.push_back(d);
+  }
+
+  ASSERT_EQ(twenty_four_puzzle::parse(twenty_four_puzzle::to_string(b)), b);
+  auto result = ida.solve(b);
+  ASSERT_TRUE(result.solved);
+  ASSERT_LE(result.moves.size(), walk.size());
+  ASSERT_EQ(apply_puzzle_moves<twenty_four_puzzle>(b, result.moves), twenty_four_puzzle::goal);
+}
+
+TEST(pattern_database_test, parse_partition) {
+  auto sizes = parse_partition("6-6-3");
+  ASSERT_TRUE(sizes.has_value());
+  ASSERT_EQ(sizes->size(), 3);
+  ASSERT_EQ((*sizes)[2], (pattern{13, 14, 15}));
+
+  auto groups = parse_partition("1,2,5,6/3,4,7,8/9,10,11,12,13,14,15");
+  ASSERT_TRUE(groups.has_value());
+  ASSERT_EQ((*groups)[1], (pattern{3, 4, 7, 8}));
+
+  ASSERT_FALSE(parse_partition("6-6-2").has_value());
+  ASSERT_FALSE(parse_partition("8-8").has_value());
+  ASSERT_FALSE(parse_partition("1,2/2,3,4,5,6,7,8,9,10,11,12,13,14,15").has_value());
+
+  // The tables of more than 8 tiles do not fit in memory nor their ranks in 32 bits
+  ASSERT_TRUE(parse_partition("8-7").has_value());
+  ASSERT_FALSE(parse_partition("9-6").has_value());
+  ASSERT_FALSE(parse_partition("15").has_value());
+  ASSERT_FALSE(parse_partition("1,2,3,4,5,6,7,8,9/10,11,12,13,14,15").has_value());
+  ASSERT_FALSE(pattern_database::generate({{1, 2, 3, 4, 5, 6, 7, 8, 9}, {10, 11, 12, 13, 14, 15}}, testing::TempDir() + "15puzzle_test.pdb",
+                                          [](std::size_t, int, uint64_t) {}));
+  ASSERT_EQ(errno, EINVAL);
+}
+
+TEST(pattern_database_test, generate_and_open) {
+  std::string path = testing::TempDir() + "15puzzle_test.pdb";
+  ASSERT_TRUE(pattern_database::generate(*parse_partition("3-3-3-3-3"), path, [](std::size_t, int, uint64_t) {}));
+
+  auto db = pattern_database::open(path);
+  ASSERT_TRUE(db.has_value());
+  ASSERT_EQ(db->patterns(), 5);
+  ASSERT_EQ(db->tiles(1), (pattern{4, 5, 6}));
+
+  manhattan_heuristic manhattan;
+  ASSERT_EQ(db->evaluate(solved_board), 0);
+  ASSERT_EQ(db->evaluate(0x1234'5678'9abc'de0f), 1);
+  for (Board b : {0x5123'9674'0ab8'defcull, 0xd2a3'1c84'5096'feb7ull})
+    ASSERT_GE(db->evaluate(b), manhattan.evaluate(b));
+  check_update(*db, solved_board, 1000);
+
+  // The solutions found with the pattern database are still optimal
+  ida_star<pattern_database> ida{*db};
+  auto result = ida.solve(0xd2a3'1c84'5096'feb7);
+  ASSERT_TRUE(result.solved);
+  ASSERT_EQ(result.moves.size(), 41);
+  ASSERT_LE(db->evaluate(0xd2a3'1c84'5096'feb7), 41);
+
+  // The fingerprint is the one of the patterns, not of the file
+  const uint64_t fingerprint = db->fingerprint();
+  ASSERT_EQ(pattern_database::open(path)->fingerprint(), fingerprint);
+  ASSERT_TRUE(pattern_database::generate(*parse_partition("4-4-4-3"), path, [](std::size_t, int, uint64_t) {}));
+  ASSERT_NE(pattern_database::open(path)->fingerprint(), fingerprint);
+
+  std::remove(path.c_str());
+}
+
+TEST(pattern_database_test, open_rejects_other_files) {
+  ASSERT_FALSE(pattern_database::open(testing::TempDir() + "does_not_exist.pdb").has_value());
+
+  std::string path = testing::TempDir() + "15puzzle_test_invalid.pdb";
+  std::FILE *file = std::fopen(path.c_str(), "wb");
+  std::vector<char> zeros(8192, 0);
+  std::fwrite(zeros.data(), 1, zeros.size(), file);
+  std::fclose(file);
+  ASSERT_FALSE(pattern_database::open(path).has_value());
+  std::remove(path.c_str());
+}
+
+TEST(telemetry_test, counters_and_histograms) {
+  search_telemetry telemetry;
+  telemetry.record_expansion(40, 2);
+  telemetry.record_expansion(40, 3);
+  telemetry.record_expansion(5000, 300);
+  telemetry.generated.add(7);
+  telemetry.duplicates.add(1);
+  telemetry.pruned.add(2);
+  telemetry.open_size.set(6);
+  telemetry.record_latency(std::chrono::nanoseconds{1000});
+
+  ASSERT_EQ(telemetry.expanded.get(), 3);
+  ASSERT_EQ(telemetry.generated.get(), 7);
+  ASSERT_EQ(telemetry.f.count(40), 2);
+  // The values out of the histogram are counted in the last bucket
+  ASSERT_EQ(telemetry.f.count(1023), 1);
+  ASSERT_EQ(telemetry.g.count(255), 1);
+  ASSERT_EQ(telemetry.latency_ns.count(9), 1);
+
+  std::ostringstream out;
+  telemetry.write_json(out, "sample", 0.5);
+  std::string line = out.str();
+  ASSERT_EQ(line.find("{\"event\":\"sample\",\"seconds\":0.5,\"expanded\":3,\"generated\":7,\"duplicates\":1,\"pruned\":2,\"open\":6,"), 0);
+  ASSERT_NE(line.find("\"f\":[[40,2],[1023,1]]"), std::string::npos);
+  ASSERT_NE(line.find("\"latency_log2_ns\":[[9,1]]"), std::string::npos);
+  ASSERT_EQ(line.back(), '\n');
+}
+
+TEST(telemetry_test, sampler_writes_on_signal_and_at_the_end) {
+  search_telemetry telemetry;
+  std::ostringstream out;
+  {
+    telemetry_sampler sampler{telemetry, out, std::chrono::milliseconds{0}};
+    telemetry.record_expansion(10, 0);
+    request_telemetry_dump(SIGUSR1);
+    while (telemetry_dump_requested)
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    sampler.stop();
+  }
+
+  std::string text = out.str();
+  auto signal = text.find("\"event\":\"signal\"");
+  auto final = text.find("\"event\":\"final\"");
+  ASSERT_NE(signal, std::string::npos);
+  ASSERT_NE(final, std::string::npos);
+  ASSERT_LT(signal, final);
+  ASSERT_EQ(text.find("\"event\":\"sample\""), std::string::npos);
+}
+
+TEST(checkpoint_test, save_and_open) {
+  std::string path = testing::TempDir() + "15puzzle_test.checkpoint";
+  std::vector<checkpoint_node> nodes = {{solved_board, no_node, 0, Nothing, 0}, {0x1234'5678'9abc'de0f, 0, 1, Left, 3}};
+  std::vector<checkpoint_open_entry> open = {{1, 3, 1}, {0, 5, 0}};
+  std::vector<std::pair<Board, uint16_t>> closed = {{solved_board, 0}, {0x1234'5678'9abc'de0f, 1}, {0x1234'5678'9ab0'def0, 7}};
+
+  checkpoint_info info{};
+  info.initial_board = 0x1234'5678'9abc'de0f;
+  info.expanded = 12;
+  info.nodes = nodes.size();
+  info.open = open.size();
+  info.closed = closed.size();
+  std::strcpy(info.heuristic, "manhattan");
+  info.has_closed_set = 1;
+  ASSERT_TRUE(checkpoint::save(
+      path, info, [&](uint64_t i) { return nodes[i]; },
+      [&](auto &&f) {
+        for (auto e : open)
+          f(e.f, e.g, e.node);
+      },
+      [&](auto &&f) {
+        for (auto [b, moves] : closed)
+          f(b, moves);
+      }));
+
+  auto c = checkpoint::open(path);
+  ASSERT_TRUE(c.has_value());
+  ASSERT_EQ(c->heuristic(), "manhattan");
+  ASSERT_EQ(c->info().initial_board, info.initial_board);
+  ASSERT_EQ(c->info().expanded, 12);
+  ASSERT_EQ(c->bytes(), checkpoint::header_size + 2 * 16 + 2 * 8 + 3 * 10);
+  ASSERT_EQ(c->node(1).board, nodes[1].board);
+  ASSERT_EQ(c->node(1).parent, 0);
+  ASSERT_EQ(c->node(1).direction, Left);
+  ASSERT_EQ(c->node(1).pruning_state, 3);
+  ASSERT_EQ(c->open_entry(0).node, 1);
+  ASSERT_EQ(c->open_entry(1).f, 5);
+  for (std::size_t i = 0; i < closed.size(); i++) {
+    ASSERT_EQ(c->closed_board(i), closed[i].first);
+    ASSERT_EQ(c->closed_moves(i), closed[i].second);
+  }
+
+  // A truncated file is not a checkpoint
+  ASSERT_EQ(truncate(path.c_str(), c->bytes() - 1), 0);
+  ASSERT_FALSE(checkpoint::open(path).has_value());
+  ASSERT_FALSE(checkpoint::open(testing::TempDir() + "does_not_exist.checkpoint").has_value());
+  std::remove(path.c_str());
+}
+
+TEST(checkpoint_test, background_checkpoint_runs_in_a_child) {
+  std::string path = testing::TempDir() + "15puzzle_test_background.checkpoint";
+  background_checkpoint checkpoints;
+  ASSERT_TRUE(checkpoints.start([&] {
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    return file != nullptr && std::fputs("written by the child", file) >= 0 && std::fclose(file) == 0;
+  }));
+  ASSERT_TRUE(checkpoints.wait());
+  ASSERT_EQ(checkpoints.written(), 1);
+  ASSERT_FALSE(checkpoints.running());
+
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  ASSERT_NE(file, nullptr);
+  char text[32] = {};
+  ASSERT_NE(std::fgets(text, sizeof(text), file), nullptr);
+  std::fclose(file);
+  ASSERT_STREQ(text, "written by the child");
+
+  ASSERT_TRUE(checkpoints.start([] { return false; }));
+  ASSERT_FALSE(checkpoints.wait());
+  ASSERT_EQ(checkpoints.written(), 1);
+  std::remove(path.c_str());
+}
+
+TEST(ara_test, improves_until_optimal_within_the_bounds) {
+  linear_conflict_heuristic heuristic;
+  ara_star<linear_conflict_heuristic> ara{heuristic, 3, 0.5};
+
+  std::vector<ara_solution> solutions;
+  auto result = ara.solve(0xd2a3'1c84'5096'feb7, ara_star<linear_conflict_heuristic>::unlimited,
+                          [&](const ara_solution &s) { solutions.push_back(s); });
+  ASSERT_TRUE(result.solved);
+  ASSERT_EQ(result.moves.size(), 41);
+  ASSERT_EQ(apply_moves(0xd2a3'1c84'5096'feb7, result.moves), solved_board);
+
+  ASSERT_GE(solutions.size(), 2);
+  ASSERT_EQ(solutions.front().weight, 3);
+  for (std::size_t i = 0; i < solutions.size(); i++) {
+    ASSERT_EQ(apply_moves(0xd2a3'1c84'5096'feb7, solutions[i].moves), solved_board);
+    ASSERT_LE(solutions[i].bound, solutions[i].weight);
+    ASSERT_LE(solutions[i].moves.size(), solutions[i].bound * 41 + 1e-9);
+    if (i > 0) {
+      ASSERT_LE(solutions[i].moves.size(), solutions[i - 1].moves.size());
+      ASSERT_LT(solutions[i].bound, solutions[i - 1].bound);
+    }
+  }
+  ASSERT_EQ(solutions.back().bound, 1);
+
+  // The solved board is solved without expanding it, with an optimal solution
+  solutions.clear();
+  result = ara.solve(solved_board, 1000, [&](const ara_solution &s) { solutions.push_back(s); });
+  ASSERT_TRUE(result.solved);
+  ASSERT_TRUE(result.moves.empty());
+  ASSERT_EQ(result.expanded, 0);
+  ASSERT_EQ(solutions.size(), 1);
+  ASSERT_EQ(solutions.front().bound, 1);
+}
+
+TEST(ara_test, unsolvable_and_limited) {
+  manhattan_heuristic heuristic;
+  ara_star<manhattan_heuristic> ara{heuristic};
+  ASSERT_FALSE(ara.solve(0x2134'5678'9abc'def0).solved);
+
+  // The first solution of a big weight is found with few expansions
+  auto result = ara.solve(0xd2a3'1c84'5096'feb7, 20000);
+  ASSERT_TRUE(result.solved);
+  ASSERT_LE(result.expanded, 20000);
+  ASSERT_EQ(apply_moves(0xd2a3'1c84'5096'feb7, result.moves), solved_board);
+}
+
+TEST(epea_test, operator_table_matches_the_heuristic) {
+  manhattan_heuristic manhattan;
+  for (Board b : {solved_board, Board{0xd2a3'1c84'5096'feb7}, Board{0x5123'9674'0ab8'defc}}) {
+    int hole = get_hole_position(b);
+    for (int d = 0; d < 4; d++) {
+      if (!playgroundcpp::board::can_move(hole, d))
+        continue;
+      auto m = playgroundcpp::board::move_hole(b, hole, d);
+      ASSERT_EQ(manhattan_operators::delta[hole][d][m.tile], manhattan.evaluate(m.board) - manhattan.evaluate(b));
+    }
+  }
+}
+
+TEST(epea_test, solves_optimally_storing_fewer_nodes) {
+  manhattan_heuristic manhattan;
+  epea_star<manhattan_heuristic> epea{manhattan};
+  auto result = epea.solve(0xd2a3'1c84'5096'feb7);
+  ASSERT_TRUE(result.solved);
+  ASSERT_EQ(result.moves.size(), 41);
+  ASSERT_EQ(apply_moves(0xd2a3'1c84'5096'feb7, result.moves), solved_board);
+  ASSERT_GT(epea.reinserted(), 0);
+  // A* stores about two children of every expanded node
+  ASSERT_LT(epea.nodes(), result.expanded);
+
+  linear_conflict_heuristic linear_conflict;
+  epea_star<linear_conflict_heuristic> with_tables{linear_conflict};
+  result = with_tables.solve(0x5123'9674'0ab8'defc);
+  ASSERT_TRUE(result.solved);
+  ASSERT_EQ(apply_moves(0x5123'9674'0ab8'defc, result.moves), solved_board);
+  ida_star<linear_conflict_heuristic> ida{linear_conflict};
+  ASSERT_EQ(result.moves.size(), ida.solve(0x5123'9674'0ab8'defc).moves.size());
+
+  ASSERT_FALSE(epea.solve(0x2134'5678'9abc'def0).solved);
+  ASSERT_FALSE(epea.solve(0xd2a3'1c84'5096'feb7, 100).solved);
+}
+
+/**
+ * walks all the paths that move_pruning allows, up to max_depth moves, keeping the shortest
+ * distance of every board.
+ */
+void walk_allowed_paths(const move_pruning &pruning, Board b, move_pruning::state s, int depth, int max_depth, board_hash_map<uint8_t> &distance,
+                        uint64_t &paths) {
+  distance.insert_or_improve(b, depth);
+  paths++;
+  if (depth == max_depth)
+    return;
+  int hole = get_hole_position(b);
+  uint8_t moves = playgroundcpp::board::legal_moves[hole] & pruning.allowed(s);
+  for (int d = 0; d < 4; d++)
+    if ((moves >> d) & 1)
+      walk_allowed_paths(pruning, playgroundcpp::board::move_hole(b, hole, d).board, pruning.next(s, static_cast<Direction>(d)), depth + 1, max_depth,
+                         distance, paths);
+}
+
+TEST(move_pruning_test, prunes_duplicates) {
+  move_pruning pruning;
+  ASSERT_LE(pruning.states(), 256);
+
+  // The moves back and one of the two half turns around a 2x2 block are pruned
+  const auto &pruned = pruning.pruned();
+  ASSERT_NE(std::find(pruned.begin(), pruned.end(), std::vector<Direction>{Up, Down}), pruned.end());
+  ASSERT_NE(std::find(pruned.begin(), pruned.end(), std::vector<Direction>{Right, Up, Left, Down, Right, Up}), pruned.end());
+  ASSERT_EQ(std::find(pruned.begin(), pruned.end(), std::vector<Direction>{Up, Right, Down, Left, Up, Right}), pruned.end());
+
+  move_pruning::state s = move_pruning::start;
+  ASSERT_EQ(pruning.allowed(s), 0xf);
+  for (Direction d : {Right, Up, Left, Down, Right})
+    s = pruning.next(s, d);
+  ASSERT_EQ((pruning.allowed(s) >> Up) & 1, 0);
+  ASSERT_EQ((pruning.allowed(s) >> Left) & 1, 0);
+}
+
+TEST(move_pruning_test, keeps_the_shortest_path_of_every_board) {
+  const int max_depth = 14;
+  move_pruning pruning;
+  for (Board start : {solved_board, Board{0x1234'5678'9ab0'cdef}, Board{0x1230'4567'89ab'cdef}}) {
+    board_hash_map<uint8_t> distance;
+    uint64_t paths = 0;
+    walk_allowed_paths(pruning, start, move_pruning::start, 0, max_depth, distance, paths);
+
+    uint64_t boards = 0;
+    layered_bfs(start, max_depth, 1, [&](int depth, const std::vector<uint64_t> &layer) {
+      boards += layer.size();
+      for (Board b : layer) {
+        auto d = distance.find(b);
+        ASSERT_NE(d, nullptr);
+        ASSERT_EQ(*d, depth);
+      }
+    });
+    ASSERT_EQ(distance.size(), boards);
+    // Without the pruning of the moves back alone, there are several paths for every board
+    ASSERT_LT(paths, 2 * boards);
+  }
+}
+
+TEST(bloom_filter_test, no_false_negatives_and_the_expected_error) {
+  blocked_bloom_filter filter{std::size_t{1} << 16};
+  ASSERT_EQ(filter.bytes(), std::size_t{1} << 16);
+  ASSERT_EQ(filter.false_positive_rate(), 0);
+
+  // Random boards: the filter only hashes them
+  std::mt19937_64 random{15};
+  std::vector<uint64_t> inserted(40000);
+  for (auto &b : inserted) {
+    b = random();
+    filter.insert(b);
+  }
+  for (auto b : inserted)
+    ASSERT_TRUE(filter.contains(b));
+  ASSERT_TRUE(filter.insert(inserted[0]));
+  ASSERT_LE(filter.size(), inserted.size());
+
+  int false_positives = 0;
+  const int queries = 200000;
+  for (int i = 0; i < queries; i++)
+    false_positives += filter.contains(random());
+  double expected = filter.false_positive_rate();
+  ASSERT_GT(expected, 0);
+  ASSERT_LT(expected, 0.05);
+  ASSERT_NEAR(static_cast<double>(false_positives) / queries, expected, expected / 2 + 0.0005);
+}
+
+TEST(solution_cache_test, stores_a_board_and_its_transpose_once) {
+  std::string path = testing::TempDir() + "15puzzle_test.cache";
+  std::remove(path.c_str());
+
+  const Board b = 0x1234'5678'9abc'0def;
+  const std::vector<Direction> moves = {Right, Right, Right};
+  ASSERT_EQ(apply_moves(b, moves), solved_board);
+  {
+    auto cache = solution_cache::open(path, 10);
+    ASSERT_TRUE(cache.has_value());
+    ASSERT_EQ(cache->capacity(), 16u);
+    ASSERT_FALSE(cache->find(b).has_value());
+    ASSERT_TRUE(cache->insert(b, moves));
+    // A longer solution does not replace the one stored
+    ASSERT_TRUE(cache->insert(b, {Right, Right, Up, Right, Down}));
+    ASSERT_EQ(cache->size(), 1u);
+  }
+
+  // The file keeps the solutions, and the transposed board has the transposed moves
+  auto cache = solution_cache::open(path, 1000);
+  ASSERT_TRUE(cache.has_value());
+  ASSERT_EQ(cache->capacity(), 16u);
+  ASSERT_EQ(cache->find(b), moves);
+  auto transposed = cache->find(transpose(b));
+  ASSERT_TRUE(transposed.has_value());
+  ASSERT_EQ(apply_moves(transpose(b), *transposed), solved_board);
+  ASSERT_EQ(*transposed, (std::vector<Direction>{Down, Down, Down}));
+
+  // 14 of the 16 slots can be used
+  std::mt19937_64 random{24};
+  int stored = 1;
+  while (stored < 20) {
+    Board other = solved_board;
+    std::vector<Direction> path;
+    for (int i = 0; i < 30; i++) {
+      Direction d = directions[random() % 4];
+      if (auto next = move(other, d)) {
+        other = *next;
+        path.insert(path.begin(), inverse(d));
+      }
+    }
+    if (cache->find(other))
+      continue;
+    if (!cache->insert(other, path))
+      break;
+    ASSERT_EQ(apply_moves(other, *cache->find(other)), solved_board);
+    stored++;
+  }
+  ASSERT_EQ(stored, 14);
+  ASSERT_EQ(cache->size(), 14u);
+  ASSERT_FALSE(cache->insert(solved_board, std::vector<Direction>(solution_cache::max_moves + 1, Up)));
+
+  std::FILE *file = std::fopen(path.c_str(), "r+b");
+  ASSERT_NE(file, nullptr);
+  std::fputc('X', file);
+  std::fclose(file);
+  ASSERT_FALSE(solution_cache::open(path).has_value());
+  std::remove(path.c_str());
+}
+
+TEST(solver_protocol_test, requests_and_responses) {
+  auto request = parse_request("d2a31c845096feb7 1000 250");
+  ASSERT_TRUE(request.has_value());
+  ASSERT_EQ(request->board, 0xd2a3'1c84'5096'feb7);
+  ASSERT_EQ(request->max_nodes, 1000u);
+  ASSERT_EQ(request->max_milliseconds, 250u);
+  ASSERT_EQ(format_request(*request), "d2a31c845096feb7 1000 250\n");
+
+  request = parse_request("123456789abcdef0");
+  ASSERT_TRUE(request.has_value());
+  ASSERT_EQ(request->max_nodes, 0u);
+  ASSERT_FALSE(parse_request("123456789abcdef").has_value());
+  ASSERT_FALSE(parse_request("123456789abcdef0 -1").has_value());
+  ASSERT_FALSE(parse_request("123456789abcdef0 1 2 3").has_value());
+
+  solve_response solved{0x1234'5678'9abc'0def, solve_status::solved, 3, 12, {Right, Right, Right}};
+  ASSERT_EQ(format_response(solved), "123456789abc0def solved 3 12 3 RRR\n");
+  auto line = format_response(solved);
+  auto parsed = parse_response(std::string_view{line}.substr(0, line.size() - 1));
+  ASSERT_TRUE(parsed.has_value());
+  ASSERT_EQ(parsed->board, solved.board);
+  ASSERT_EQ(parsed->moves, solved.moves);
+
+  ASSERT_EQ(format_response({solved_board, solve_status::solved, 0, 1, {}}), "123456789abcdef0 solved 0 1 0 -\n");
+  ASSERT_TRUE(parse_response("123456789abcdef0 solved 0 1 0 -").has_value());
+  ASSERT_EQ(format_response({solved_board, solve_status::time_limit, 5000, 10, {}}), "123456789abcdef0 time-limit 5000 10\n");
+  ASSERT_EQ(parse_response("123456789abcdef0 node-limit 5000 10")->status, solve_status::node_limit);
+  ASSERT_FALSE(parse_response("123456789abcdef0 solved 3 12 2 RRR").has_value());
+  ASSERT_FALSE(parse_response("0123456789abcdef error the board cannot be solved").has_value());
+
+  // The errors start with the board, when it can be read
+  ASSERT_EQ(format_error("0123456789abcdef 10", "the board cannot be solved"), "0123456789abcdef error the board cannot be solved\n");
+  ASSERT_EQ(format_error("123456789abcdef0 x", "invalid request"), "123456789abcdef0 error invalid request\n");
+  ASSERT_EQ(format_error("hello", "invalid request"), "error invalid request hello\n");
+}
+
+TEST(unix_socket_test, line_reader_splits_the_lines) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  ASSERT_TRUE(send_all(fds[0], "first\r\nsec"));
+
+  line_reader reader;
+  std::string line;
+  ASSERT_TRUE(reader.read(fds[1]));
+  ASSERT_TRUE(reader.next(line));
+  ASSERT_EQ(line, "first");
+  ASSERT_FALSE(reader.next(line));
+
+  ASSERT_TRUE(send_all(fds[0], "ond\n"));
+  ASSERT_TRUE(reader.read(fds[1]));
+  ASSERT_TRUE(reader.next(line));
+  ASSERT_EQ(line, "second");
+
+  ::close(fds[0]);
+  ASSERT_FALSE(reader.read(fds[1]));
+  ::close(fds[1]);
+}
+
+TEST(unix_socket_test, listen_only_replaces_abandoned_sockets) {
+  std::string path = testing::TempDir() + "15puzzle_test.sock";
+  ::unlink(path.c_str());
+  int listener = listen_unix(path);
+  ASSERT_GE(listener, 0);
+
+  // Another process listens on the socket
+  ASSERT_EQ(listen_unix(path), -1);
+  ASSERT_EQ(errno, EADDRINUSE);
+
+  // The socket of a process that has ended is replaced
+  ::close(listener);
+  listener = listen_unix(path);
+  ASSERT_GE(listener, 0);
+  ::close(listener);
+  ::unlink(path.c_str());
+
+  // Other files are not removed
+  std::FILE *file = std::fopen(path.c_str(), "w");
+  ASSERT_NE(file, nullptr);
+  std::fclose(file);
+  ASSERT_EQ(listen_unix(path), -1);
+  ASSERT_EQ(errno, EADDRINUSE);
+  ASSERT_EQ(::access(path.c_str(), F_OK), 0);
+  ::unlink(path.c_str());
+}
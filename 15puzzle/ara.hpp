@@ -0,0 +1,265 @@
+#pragma once
+
+#include "board.hpp"
+#include "bucket_queue.hpp"
+#include "closed_set.hpp"
+#include "node_arena.hpp"
+#include "search_result.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * ara_solution is a solution found by ara_star, with the weight used to find it and the proven
+ * bound of its suboptimality: it is at most bound times longer than the optimal one.
+ */
+struct ara_solution {
+  std::vector<Direction> moves;
+  double weight;
+  double bound;
+  uint64_t expanded;
+};
+
+/**
+ * ara_star is an anytime weighted A* (Likhachev, Gordon and Thrun, "ARA*: Anytime A* with
+ * provable bounds on sub-optimality"). The first search uses g + weight * h, that finds a
+ * solution expanding few nodes, and every next search lowers the weight until it is 1 and the
+ * solution is optimal.
+ *
+ * The searches reuse the work of the previous ones: the nodes keep their g and their parent,
+ * the open list is only ordered again with the new weight, and a node is expanded again only
+ * if its g improved after it was expanded (those nodes wait in the inconsistent list until the
+ * next search). Every node is expanded at most once in each search.
+ *
+ * The weights are used in tenths, so the priorities are integers and the open list is a
+ * bucket_queue.
+ *
+ * \tparam Heuristic an admissible heuristic, as described in heuristic.hpp. The bounds are
+ *                   not valid with the others.
+ */
+template <class Heuristic> class ara_star {
+public:
+  static constexpr uint64_t unlimited = std::numeric_limits<uint64_t>::max();
+
+  /**
+   * \param initial_weight the weight of the first search.
+   * \param weight_step the weight is lowered by this amount after each search.
+   */
+  ara_star(const Heuristic &heuristic, double initial_weight = 3, double weight_step = 0.5)
+      : heuristic_{heuristic}, initial_weight_{std::max(10, static_cast<int>(std::lround(initial_weight * 10)))},
+        weight_step_{std::max(1, static_cast<int>(std::lround(weight_step * 10)))} {}
+
+  /**
+   * solve searches better and better solutions of the board until the optimal one is found,
+   * there are no more nodes or max_nodes are expanded.
+   *
+   * \param max_nodes the search stops after expanding this number of nodes, in all the
+   *                  searches.
+   * \param on_solution called with an ara_solution every time a shorter solution is found
+   *                    or its bound is improved.
+   * \return the best solution found.
+   */
+  template <class Observer> search_result solve(Board initial, uint64_t max_nodes, Observer &&on_solution) {
+    search_result result;
+    if (!is_board_solvable(initial))
+      return result;
+    if (initial == solved_board) {
+      result.solved = true;
+      on_solution(ara_solution{{}, initial_weight_ / 10.0, 1, 0});
+      return result;
+    }
+
+    reset();
+    int h = heuristic_.evaluate(initial);
+    node_handle root = nodes_.push_back({initial, no_node, 0, static_cast<uint16_t>(h), Nothing, 0});
+    index_.insert_or_assign(initial, root);
+    weight_ = initial_weight_;
+    push_open(root);
+
+    double last_bound = std::numeric_limits<double>::infinity();
+    while (true) {
+      bool finished = improve_path(max_nodes, result);
+
+      if (goal_ != no_node) {
+        // Every node that can lead to a better solution is in the open or in the inconsistent list.
+        // There is no bound for a search that was stopped before it finished.
+        double bound = std::numeric_limits<double>::infinity();
+        if (finished) {
+          uint32_t min_f = lower_bound();
+          bound = min_f == 0 ? 1 : std::min(weight_ / 10.0, static_cast<double>(nodes_[goal_].g) / min_f);
+        }
+        if (nodes_[goal_].g < result.moves.size() || !result.solved || bound < last_bound) {
+          result.solved = true;
+          result.moves = path_to(goal_);
+          last_bound = bound;
+          on_solution(ara_solution{result.moves, weight_ / 10.0, bound, result.expanded});
+        }
+        if (bound <= 1)
+          return result;
+      }
+
+      if (!finished || (open_.empty() && inconsistent_.empty()) || weight_ == 10)
+        return result;
+
+      weight_ = std::max(10, weight_ - weight_step_);
+      reorder_open();
+    }
+  }
+
+  search_result solve(Board initial, uint64_t max_nodes = unlimited) {
+    return solve(initial, max_nodes, [](const ara_solution &) {});
+  }
+
+  /**
+   * returns the number of different boards generated.
+   */
+  std::size_t nodes() const { return nodes_.size(); }
+
+  std::size_t bytes() const { return nodes_.bytes() + index_.bytes(); }
+
+private:
+  struct node {
+    Board board;
+    node_handle parent;
+    uint16_t g;
+    uint16_t h;
+    Direction direction;
+    /**
+     * closed_in is the number of the search that expanded it, 0 if it was not expanded.
+     */
+    uint32_t closed_in;
+  };
+
+  void reset() {
+    nodes_.clear();
+    index_.clear();
+    open_.clear();
+    inconsistent_.clear();
+    goal_ = no_node;
+    search_ = 1;
+  }
+
+  uint32_t key(const node &n) const { return 10u * n.g + static_cast<uint32_t>(weight_) * n.h; }
+
+  void push_open(node_handle h) { open_.push(key(nodes_[h]), nodes_[h].g, h); }
+
+  /**
+   * improve_path is a weighted A* that stops when no node of the open list can lead to a
+   * better solution with the current weight.
+   *
+   * \return false if it was stopped by max_nodes.
+   */
+  bool improve_path(uint64_t max_nodes, search_result &result) {
+    while (!open_.empty() && (goal_ == no_node || 10u * nodes_[goal_].g > open_.top_f())) {
+      node_handle top = open_.top();
+      uint32_t top_g = open_.top_g();
+      open_.pop();
+
+      // The node is also in the open list with its new g
+      if (top_g != nodes_[top].g)
+        continue;
+
+      if (result.expanded >= max_nodes)
+        return false;
+
+      nodes_[top].closed_in = search_;
+      result.expanded++;
+
+      const Board board = nodes_[top].board;
+      const uint16_t g = nodes_[top].g + 1;
+      const int h = nodes_[top].h;
+      const Direction from = nodes_[top].direction;
+      const auto children = playgroundcpp::board::successors_of(board);
+      for (int i = 0; i < children.count; i++) {
+        const Direction d = static_cast<Direction>(children.directions[i]);
+        if (d == inverse(from))
+          continue;
+
+        result.generated++;
+        const tile_move &m = children.moves[i];
+        node_handle child;
+        if (auto found = index_.find(m.board)) {
+          child = *found;
+          if (g >= nodes_[child].g)
+            continue;
+          nodes_[child].g = g;
+          nodes_[child].parent = top;
+          nodes_[child].direction = d;
+        } else {
+          child = nodes_.push_back({m.board, top, g, static_cast<uint16_t>(heuristic_.update(h, m)), d, 0});
+          index_.insert_or_assign(m.board, child);
+          if (m.board == solved_board)
+            goal_ = child;
+        }
+
+        if (nodes_[child].closed_in == search_)
+          inconsistent_.push_back(child);
+        else
+          push_open(child);
+      }
+    }
+    return true;
+  }
+
+  /**
+   * returns the smallest g + h of the open and the inconsistent lists, that is a lower bound of
+   * the length of the optimal solution, or 0 if they are empty.
+   */
+  uint32_t lower_bound() const {
+    uint32_t min_f = std::numeric_limits<uint32_t>::max();
+    open_.for_each([&](uint32_t, uint32_t g, node_handle h) {
+      if (g == nodes_[h].g)
+        min_f = std::min<uint32_t>(min_f, nodes_[h].g + nodes_[h].h);
+    });
+    for (node_handle h : inconsistent_)
+      min_f = std::min<uint32_t>(min_f, nodes_[h].g + nodes_[h].h);
+    return min_f == std::numeric_limits<uint32_t>::max() ? 0 : min_f;
+  }
+
+  /**
+   * reorder_open moves the inconsistent nodes to the open list and orders it with the new
+   * weight. The nodes expanded in the last search can be expanded again in the next one.
+   */
+  void reorder_open() {
+    std::vector<node_handle> open;
+    open.reserve(open_.size() + inconsistent_.size());
+    open_.for_each([&](uint32_t, uint32_t g, node_handle h) {
+      if (g == nodes_[h].g)
+        open.push_back(h);
+    });
+    open.insert(open.end(), inconsistent_.begin(), inconsistent_.end());
+    std::sort(open.begin(), open.end());
+    open.erase(std::unique(open.begin(), open.end()), open.end());
+
+    open_.clear();
+    inconsistent_.clear();
+    search_++;
+    for (node_handle h : open)
+      push_open(h);
+  }
+
+  std::vector<Direction> path_to(node_handle h) const {
+    std::vector<Direction> moves;
+    for (; nodes_[h].direction != Nothing; h = nodes_[h].parent)
+      moves.push_back(nodes_[h].direction);
+    std::reverse(moves.begin(), moves.end());
+    return moves;
+  }
+
+  const Heuristic &heuristic_;
+  const int initial_weight_;
+  const int weight_step_;
+  /**
+   * weight_ is the weight of the current search in tenths.
+   */
+  int weight_ = 10;
+  uint32_t search_ = 1;
+  node_arena<node> nodes_;
+  board_hash_map<node_handle> index_;
+  bucket_queue<node_handle> open_;
+  std::vector<node_handle> inconsistent_;
+  node_handle goal_ = no_node;
+};
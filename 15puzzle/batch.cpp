@@ -0,0 +1,199 @@
+#include "board.hpp"
+#include "heuristic.hpp"
+#include "ida.hpp"
+#include "pattern_database.hpp"
+#include "search_result.hpp"
+
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/**
+ * batch_options are the parameters of the batch read from the command line.
+ */
+struct batch_options {
+  unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+  uint64_t max_nodes = ida_star<manhattan_heuristic>::unlimited;
+  bool print_moves = false;
+};
+
+/**
+ * read_board parses a line of the input: a board in hexadecimal or the list of its tiles.
+ */
+std::optional<Board> read_board(std::string_view line) {
+  if (auto board = parse_board(line))
+    return board;
+  return parse_tiles(line);
+}
+
+/**
+ * batch solves every board of the input with IDA*, one board per task. The workers take the
+ * lines from the input as they finish, so the input can be a pipe and it is never loaded
+ * whole. Each worker only needs the stack of its IDA*, and the heuristic is shared by all of
+ * them, read only.
+ *
+ * A line is printed for every board as soon as it is solved, so the order of the output is not
+ * the one of the input; the first column is the line number.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> int batch(std::istream &input, const batch_options &options, const Heuristic &heuristic) {
+  std::mutex input_mutex;
+  std::mutex output_mutex;
+  uint64_t line_number = 0;
+  std::atomic<uint64_t> boards = 0;
+  std::atomic<uint64_t> solved = 0;
+  std::atomic<uint64_t> expanded = 0;
+  std::atomic<bool> has_errors = false;
+
+  auto start_time = std::chrono::steady_clock::now();
+  laparca::thread_pool pool(options.threads, [&]() {
+    ida_star<Heuristic> ida{heuristic};
+    std::string line;
+
+    while (true) {
+      uint64_t number;
+      {
+        std::lock_guard lock{input_mutex};
+        if (!std::getline(input, line))
+          break;
+        number = ++line_number;
+      }
+
+      auto first = line.find_first_not_of(" \t\r");
+      if (first == std::string::npos || line[first] == '#')
+        continue;
+      auto last = line.find_last_not_of(" \t\r");
+      std::string_view text = std::string_view{line}.substr(first, last - first + 1);
+
+      auto board = read_board(text);
+      if (!board || !is_board_solvable(*board)) {
+        has_errors = true;
+        std::lock_guard lock{output_mutex};
+        std::cerr << "Line " << number << ": " << (board ? "the board cannot be solved" : "invalid board") << " " << text << std::endl;
+        continue;
+      }
+
+      auto board_start = std::chrono::steady_clock::now();
+      auto result = ida.solve(*board, options.max_nodes);
+      std::chrono::duration<double> duration = std::chrono::steady_clock::now() - board_start;
+
+      boards++;
+      expanded += result.expanded;
+      if (result.solved)
+        solved++;
+
+      std::ostringstream out;
+      out << number << " " << std::hex << std::setw(16) << std::setfill('0') << *board << std::dec << " ";
+      if (result.solved)
+        out << "moves = " << result.moves.size();
+      else
+        out << "unsolved";
+      out << "; expanded = " << result.expanded << "; duration = " << duration.count();
+      if (options.print_moves && result.solved)
+        out << "; solution = " << result.moves;
+
+      std::lock_guard lock{output_mutex};
+      std::cout << out.str() << std::endl;
+    }
+  });
+  pool.join();
+  std::chrono::duration<double> total = std::chrono::steady_clock::now() - start_time;
+
+  std::cout << "Threads   : " << options.threads << std::endl;
+  std::cout << "Boards    : " << boards << std::endl;
+  std::cout << "Solved    : " << solved << std::endl;
+  std::cout << "Expanded  : " << expanded << std::endl;
+  std::cout << "Duration  : " << total.count() << "; " << std::setprecision(10) << boards * 3600 / total.count() << " boards / h" << std::endl;
+
+  return has_errors ? 1 : 0;
+}
+
+int main(int argc, const char **argv) {
+  batch_options options;
+  std::optional<pattern_database> pdb;
+  std::string_view heuristic_name = "manhattan";
+  std::ifstream file;
+
+  using namespace std::literals;
+
+  for (int arg = 1; arg < argc; arg++) {
+    if ("--input"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        file.open(argv[++arg]);
+        if (!file) {
+          std::cerr << "Cannot open " << argv[arg] << ": " << std::strerror(errno) << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No input file found" << std::endl;
+        return 1;
+      }
+    } else if ("--threads"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.threads = std::stoul(argv[++arg]);
+        if (options.threads == 0) {
+          std::cerr << "Invalid number of threads " << argv[arg] << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No number of threads found" << std::endl;
+        return 1;
+      }
+    } else if ("--max-nodes"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.max_nodes = std::stoull(argv[++arg]);
+      } else {
+        std::cerr << "No number of nodes found" << std::endl;
+        return 1;
+      }
+    } else if ("--heuristic"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        heuristic_name = argv[++arg];
+      } else {
+        std::cerr << "No heuristic found" << std::endl;
+        return 1;
+      }
+    } else if ("--pdb"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        pdb = pattern_database::open(argv[++arg]);
+        if (!pdb) {
+          std::cerr << "Cannot load the pattern database " << argv[arg] << ": " << std::strerror(errno) << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No pattern database found" << std::endl;
+        return 1;
+      }
+    } else if ("--moves"sv == argv[arg]) {
+      options.print_moves = true;
+    } else {
+      std::cerr << "Unknown option " << argv[arg] << std::endl;
+      return 1;
+    }
+  }
+
+  std::istream &input = file.is_open() ? static_cast<std::istream &>(file) : std::cin;
+
+  if (pdb)
+    return batch(input, options, *pdb);
+
+  if (auto status = with_heuristic(heuristic_name, [&](const auto &heuristic) { return batch(input, options, heuristic); }))
+    return *status;
+
+  std::cerr << "Unknown heuristic " << heuristic_name << std::endl;
+  return 1;
+}
@@ -0,0 +1,197 @@
+#include "board.hpp"
+#include "heuristic.hpp"
+#include "squared_manhattan.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <sys/wait.h>
+#include <vector>
+
+/*
+ * 15puzzle_benchmark measures the board primitives and the solvers.
+ *
+ * The results are compared between commits with the JSON output of Google Benchmark:
+ *
+ *     15puzzle_benchmark --benchmark_out=before.json --benchmark_out_format=json
+ *     ...
+ *     compare.py benchmarks before.json after.json
+ *
+ * compare.py is in the tools directory of Google Benchmark.
+ */
+
+/**
+ * random_walk_instances returns boards made with random walks from the solved board. The walks
+ * never undo the previous move and the generator is fixed, so the instances are the same in
+ * every run and every machine.
+ */
+std::vector<Board> random_walk_instances(std::size_t count, int length, uint32_t seed) {
+  std::vector<Board> boards;
+  for (std::size_t i = 0; i < count; i++) {
+    Board b = solved_board;
+    Direction last = Nothing;
+    for (int step = 0; step < length;) {
+      seed = seed * 1103515245 + 12345;
+      Direction d = directions[(seed >> 16) % 4];
+      if (d == inverse(last))
+        continue;
+      auto next = move(b, d);
+      if (!next)
+        continue;
+      b = *next;
+      last = d;
+      step++;
+    }
+    boards.push_back(b);
+  }
+  return boards;
+}
+
+const std::vector<Board> boards = random_walk_instances(1024, 100, 1);
+
+static void BM_get_hole_position(benchmark::State &state) {
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(get_hole_position(boards[i++ % boards.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_get_hole_position);
+
+static void BM_move(benchmark::State &state) {
+  std::size_t i = 0;
+  for (auto _ : state) {
+    const Board &b = boards[i++ % boards.size()];
+    for (auto d : directions)
+      benchmark::DoNotOptimize(move(b, d));
+  }
+  state.SetItemsProcessed(state.iterations() * 4);
+}
+BENCHMARK(BM_move);
+
+static void BM_successors_of(benchmark::State &state) {
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(playgroundcpp::board::successors_of(boards[i++ % boards.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_successors_of);
+
+static void BM_count_board_inversions(benchmark::State &state) {
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(count_board_inversions(boards[i++ % boards.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_count_board_inversions);
+
+static void BM_manhattam_distances_sum_of(benchmark::State &state) {
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manhattam_distances_sum_of(boards[i++ % boards.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_manhattam_distances_sum_of);
+
+static void BM_manhattan_heuristic(benchmark::State &state) {
+  manhattan_heuristic h;
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(h.evaluate(boards[i++ % boards.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_manhattan_heuristic);
+
+/**
+ * solve_output is what is read from the output of a solver.
+ */
+struct solve_output {
+  /**
+   * ran is false if the solver could not be started or did not exit with status 0.
+   */
+  bool ran = false;
+  bool solved = false;
+  uint64_t iterations = 0;
+};
+
+/**
+ * run_solver runs a solver binary for the board and reads its output.
+ */
+solve_output run_solver(const std::string &binary, Board board, uint64_t max) {
+  std::ostringstream command;
+  // The telemetry is only written at the end, and it goes to standard error, not to the parsed output
+  command << binary << " " << max << " --telemetry-interval 0 --board " << std::hex << std::setw(16) << std::setfill('0') << board << " 2>/dev/null";
+
+  solve_output output;
+  FILE *pipe = popen(command.str().c_str(), "r");
+  if (pipe == nullptr)
+    return output;
+
+  using namespace std::literals;
+
+  char line[4096];
+  while (std::fgets(line, sizeof(line), pipe) != nullptr) {
+    std::string_view text{line};
+    if (text.substr(0, "Iterations: "sv.size()) == "Iterations: "sv)
+      output.iterations = std::stoull(std::string{text.substr("Iterations: "sv.size())});
+    else if (text.substr(0, "Solution: "sv.size()) == "Solution: "sv)
+      output.solved = true;
+  }
+  int status = pclose(pipe);
+  output.ran = status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+  return output;
+}
+
+/**
+ * BM_solve runs a build variant of the A* on a set of random walk instances. Every iteration
+ * solves all the instances, one process each.
+ */
+static void BM_solve(benchmark::State &state, const std::string &variant, int walk_length) {
+  const std::string binary = std::string{FIFTEEN_PUZZLE_BINARY_DIR} + "/" + variant;
+  const auto instances = random_walk_instances(8, walk_length, 42);
+  constexpr uint64_t max = 1'000'000;
+
+  uint64_t solved = 0;
+  uint64_t iterations = 0;
+  for (auto _ : state) {
+    for (Board b : instances) {
+      auto output = run_solver(binary, b, max);
+      if (!output.ran) {
+        state.SkipWithError(("Cannot run " + binary).c_str());
+        return;
+      }
+      solved += output.solved;
+      iterations += output.iterations;
+    }
+  }
+
+  state.counters["solved"] = benchmark::Counter(solved, benchmark::Counter::kAvgIterations);
+  state.counters["expanded"] = benchmark::Counter(iterations, benchmark::Counter::kAvgIterations);
+  state.counters["expanded_rate"] = benchmark::Counter(iterations, benchmark::Counter::kIsRate);
+}
+
+int main(int argc, char **argv) {
+  for (const char *variant : {"15puzzle_normal", "15puzzle_visited", "15puzzle_sorted_visited", "15puzzle_clean"})
+    for (int walk_length : {20, 40})
+      benchmark::RegisterBenchmark((std::string{"BM_solve/"} + variant + "/walk:" + std::to_string(walk_length)).c_str(), BM_solve, std::string{variant},
+                                   walk_length)
+          ->Unit(benchmark::kMillisecond)
+          ->UseRealTime()
+          ->Iterations(1);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
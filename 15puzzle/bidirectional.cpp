@@ -0,0 +1,99 @@
+#include "bidirectional.hpp"
+#include "board.hpp"
+#include "heuristic.hpp"
+#include "pattern_database.hpp"
+#include "search_result.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string_view>
+
+/**
+ * solve runs the bidirectional search and prints the solution. The backward search estimates
+ * the moves to the initial board with its Manhattan distance.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp, used by the forward search.
+ */
+template <class Heuristic> int solve(Board initial_board, uint64_t max_nodes, const Heuristic &heuristic) {
+  manhattan_to_heuristic backward{initial_board};
+  bidirectional_search<Heuristic, manhattan_to_heuristic> search{heuristic, backward};
+
+  auto start_time = std::chrono::system_clock::now();
+  auto result = search.solve(initial_board, max_nodes);
+  std::chrono::duration<double> total = std::chrono::system_clock::now() - start_time;
+
+  std::cout << "Expanded  : " << result.expanded << std::endl;
+  std::cout << "Generated : " << result.generated << std::endl;
+  std::cout << "Duration  : " << total.count() << "; " << std::setprecision(10) << result.expanded / total.count() << " nodes / s" << std::endl;
+
+  if (!result.solved) {
+    std::cout << "There isn't solution" << std::endl;
+  } else {
+    std::cout << "Moves     : " << result.moves.size() << std::endl;
+    std::cout << "Solution: " << result.moves << std::endl;
+  }
+
+  return 0;
+}
+
+int main(int argc, const char **argv) {
+  Board initial_board = default_board;
+  uint64_t max_nodes = bidirectional_search<manhattan_heuristic, manhattan_to_heuristic>::unlimited;
+  std::optional<pattern_database> pdb;
+  std::string_view heuristic_name = "manhattan";
+
+  using namespace std::literals;
+
+  for (int arg = 1; arg < argc; arg++) {
+    if ("--board"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        auto board = parse_board(argv[++arg]);
+        if (!board) {
+          std::cerr << "Invalid board " << argv[arg] << std::endl;
+          return 1;
+        }
+        initial_board = *board;
+      } else {
+        std::cerr << "No board found" << std::endl;
+        return 1;
+      }
+    } else if ("--heuristic"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        heuristic_name = argv[++arg];
+      } else {
+        std::cerr << "No heuristic found" << std::endl;
+        return 1;
+      }
+    } else if ("--pdb"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        pdb = pattern_database::open(argv[++arg]);
+        if (!pdb) {
+          std::cerr << "Cannot load the pattern database " << argv[arg] << ": " << std::strerror(errno) << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No pattern database found" << std::endl;
+        return 1;
+      }
+    } else
+      max_nodes = std::stoull(argv[arg]);
+  }
+
+  if (!is_board_solvable(initial_board)) {
+    std::cerr << "The board cannot be solved." << std::endl;
+    return 2;
+  }
+
+  if (pdb)
+    return solve(initial_board, max_nodes, *pdb);
+
+  if (auto status = with_heuristic(heuristic_name, [&](const auto &heuristic) { return solve(initial_board, max_nodes, heuristic); }))
+    return *status;
+
+  std::cerr << "Unknown heuristic " << heuristic_name << std::endl;
+  return 1;
+}
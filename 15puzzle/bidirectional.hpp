@@ -0,0 +1,151 @@
+#pragma once
+
+#include "board.hpp"
+#include "bucket_queue.hpp"
+#include "closed_set.hpp"
+#include "node_arena.hpp"
+#include "search_result.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+/**
+ * bidirectional_search runs MM (Holte et al., "Bidirectional search that is guaranteed to
+ * meet in the middle"): an A* from the initial board towards the solved one and another one
+ * from the solved board towards the initial one. Every node is prioritized by
+ * pr = max(g + h, 2 g), so neither search goes beyond half of the solution before meeting the
+ * other one.
+ *
+ * Every direction keeps its nodes in an arena and a hash map from board to its best node.
+ * When a board is generated, the map of the other direction tells if the two searches meet
+ * there and the best meeting point is kept. The search stops when the best solution is not
+ * longer than the smallest priority of both open lists, then the two halves are spliced.
+ *
+ * \tparam Forward a heuristic, as described in heuristic.hpp, estimating the moves to the solved board.
+ * \tparam Backward a heuristic estimating the moves to the initial board.
+ */
+template <class Forward, class Backward> class bidirectional_search {
+public:
+  static constexpr uint64_t unlimited = std::numeric_limits<uint64_t>::max();
+
+  bidirectional_search(const Forward &forward, const Backward &backward) : forward_{forward}, backward_{backward} {}
+
+  /**
+   * solve searches the moves that solve the board.
+   *
+   * \param max_nodes the search stops after expanding this number of nodes.
+   */
+  search_result solve(Board initial, uint64_t max_nodes = unlimited) {
+    search_result result;
+    if (!is_board_solvable(initial))
+      return result;
+
+    half forward;
+    half backward;
+    forward.start(initial, forward_.evaluate(initial));
+    backward.start(solved_board, backward_.evaluate(solved_board));
+
+    best_ = initial == solved_board ? 0 : no_solution;
+    meeting_forward_ = 0;
+    meeting_backward_ = 0;
+
+    while (!forward.open.empty() && !backward.open.empty()) {
+      uint32_t c = std::min(forward.open.top_f(), backward.open.top_f());
+      if (best_ <= c)
+        break;
+
+      if (result.expanded >= max_nodes)
+        return result;
+
+      // The direction with the smallest priority goes on, or the one with less nodes to expand
+      if (forward.open.top_f() < backward.open.top_f() ||
+          (forward.open.top_f() == backward.open.top_f() && forward.open.size() <= backward.open.size()))
+        expand(forward, backward, forward_, true, result);
+      else
+        expand(backward, forward, backward_, false, result);
+    }
+
+    if (best_ == no_solution)
+      return result;
+
+    result.solved = true;
+    for (node_handle h = meeting_forward_; forward.nodes[h].direction != Nothing; h = forward.nodes[h].parent)
+      result.moves.push_back(forward.nodes[h].direction);
+    std::reverse(result.moves.begin(), result.moves.end());
+    // The backward moves go from the solved board to the meeting point, so they are undone
+    for (node_handle h = meeting_backward_; backward.nodes[h].direction != Nothing; h = backward.nodes[h].parent)
+      result.moves.push_back(inverse(backward.nodes[h].direction));
+
+    return result;
+  }
+
+private:
+  static constexpr uint32_t no_solution = std::numeric_limits<uint32_t>::max();
+
+  struct node {
+    Board board;
+    node_handle parent;
+    uint16_t g;
+    uint16_t h;
+    Direction direction;
+  };
+
+  struct half {
+    node_arena<node> nodes;
+    bucket_queue<node_handle> open;
+    board_hash_map<node_handle> best;
+
+    void start(Board b, int h) {
+      node_handle root = nodes.push_back({b, no_node, 0, static_cast<uint16_t>(h), Nothing});
+      best.insert_or_assign(b, root);
+      open.push(h, 0, root);
+    }
+  };
+
+  static uint32_t priority(int g, int h) { return std::max(g + h, 2 * g); }
+
+  template <class Heuristic> void expand(half &self, half &other, const Heuristic &heuristic, bool is_forward, search_result &result) {
+    node_handle top = self.open.top();
+    self.open.pop();
+
+    const node current = self.nodes[top];
+    // A shorter path to the board was found after this node was queued
+    if (*self.best.find(current.board) != top)
+      return;
+
+    result.expanded++;
+
+    for (auto d : directions) {
+      if (d == inverse(current.direction))
+        continue;
+
+      auto m = move_tile(current.board, d);
+      if (!m)
+        continue;
+
+      result.generated++;
+      uint16_t g = current.g + 1;
+      auto *known = self.best.find(m->board);
+      if (known != nullptr && self.nodes[*known].g <= g)
+        continue;
+
+      uint16_t h = heuristic.update(current.h, *m);
+      node_handle child = self.nodes.push_back({m->board, top, g, h, d});
+      self.best.insert_or_assign(m->board, child);
+      self.open.push(priority(g, h), g, child);
+
+      if (auto *meeting = other.best.find(m->board); meeting != nullptr && static_cast<uint32_t>(g + other.nodes[*meeting].g) < best_) {
+        best_ = g + other.nodes[*meeting].g;
+        meeting_forward_ = is_forward ? child : *meeting;
+        meeting_backward_ = is_forward ? *meeting : child;
+      }
+    }
+  }
+
+  const Forward &forward_;
+  const Backward &backward_;
+  uint32_t best_ = no_solution;
+  node_handle meeting_forward_ = 0;
+  node_handle meeting_backward_ = 0;
+};
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <playgroundcpp/board.hh>
+#include <string_view>
+
+/* A board is stored in a 64 bit value, 4 bits per position, where 0 is the hole.
+ * The position 0 is the lowest nibble. Printed in hexadecimal, the board reads
+ * like the puzzle, left to right and top to bottom:
+ *
+ *                     +--+--+--+--+
+ *                     | 1| 2| 3| 4|
+ *                     +--+--+--+--+
+ *                     | 5| 6| 7| 8|
+ *                     +--+--+--+--+
+ *                     | 9|10|11|12|
+ *                     +--+--+--+--+
+ *                     |13|14|15|  |
+ *                     +--+--+--+--+
+ *
+ * is 0x1234'5678'9abc'def0, the solved board.
+ */
+using Board = uint64_t;
+
+constexpr Board solved_board = 0x1234'5678'9abc'def0;
+
+/**
+ * default_board is the board of the solvers when no board is given. It is solvable, with an
+ * optimal solution of 41 moves.
+ */
+constexpr Board default_board = 0xd2a3'1c84'5096'feb7;
+
+struct coord {
+  int x;
+  int y;
+};
+
+inline coord operator+(const coord &a, const coord &b) { return {a.x + b.x, a.y + b.y}; }
+
+/**
+ * Directions where the hole moves.
+ */
+enum Direction : uint8_t { Up, Right, Down, Left, Nothing };
+
+constexpr Direction directions[] = {Up, Right, Down, Left};
+
+constexpr coord direction_to_coord[]{/*[Up   ] =*/{0, 1},
+                                     /*[Right] =*/{-1, 0},
+                                     /*[Down ] =*/{0, -1},
+                                     /*[Left ] =*/{1, 0}};
+
+/**
+ * returns the direction that undoes d.
+ */
+constexpr Direction inverse(Direction d) { return d == Nothing ? Nothing : static_cast<Direction>((d + 2) % 4); }
+
+/**
+ * returns the direction of the hole in the transposed board (see transpose) when it moves d
+ * in the board: the reflection across the main diagonal swaps Up and Left, and Right and Down.
+ */
+constexpr Direction transpose(Direction d) { return d == Nothing ? Nothing : static_cast<Direction>(3 - d); }
+
+inline coord position_to_coord(int p) { return {p % 4, p / 4}; }
+
+inline int coord_to_position(const coord &c) { return (c.y * 4) + c.x; }
+
+inline int get_hole_position(const Board &b) { return playgroundcpp::board::hole_position(b); }
+
+/**
+ * counts the pairs of tiles that are in the wrong order reading the board left to right
+ * and top to bottom.
+ */
+inline int count_board_inversions(const Board &b) { return playgroundcpp::board::inversions(b); }
+
+/**
+ * In a board with an even width, every vertical move of the hole changes the parity of
+ * the inversions. The board is solvable when the parity of the inversions plus the row
+ * of the hole (counted from the bottom, where it is in the solved board) is even.
+ */
+inline bool is_board_solvable(const Board &b) { return playgroundcpp::board::is_solvable(b); }
+
+/**
+ * transpose reflects the board across its main diagonal and relabels the tiles with the same
+ * reflection, so the solved board is its own transpose. The transposed board needs the same
+ * moves to be solved, with the directions transposed: a solution of one is a solution of both.
+ */
+inline Board transpose(Board b) {
+  // The position (x, y) goes to (y, x). The tiles are numbered in reading order, that is reflected the same way
+  constexpr auto reflect = [](int p) { return 4 * (p % 4) + p / 4; };
+  Board t = 0;
+  for (int p = 0; p < 16; p++) {
+    const int tile = (b >> (4 * p)) & 0xf;
+    const Board transposed_tile = tile == 0 ? 0 : reflect(tile - 1) + 1;
+    t |= transposed_tile << (4 * reflect(p));
+  }
+  return t;
+}
+
+/**
+ * tile_move describes a move: the new board, the tile that was moved and the positions
+ * it moved from and to. The hole moves the other way.
+ */
+using tile_move = playgroundcpp::board::tile_move;
+
+inline std::optional<tile_move> move_tile(const Board &b, Direction d) {
+  int hole = get_hole_position(b);
+  if (!playgroundcpp::board::can_move(hole, d))
+    return {};
+
+  return {playgroundcpp::board::move_hole(b, hole, d)};
+}
+
+inline std::optional<Board> move(const Board &b, Direction d) {
+  auto m = move_tile(b, d);
+  if (!m)
+    return {};
+  return {m->board};
+}
+
+/**
+ * parse_board reads a board written in hexadecimal, as it is printed. The 0x prefix and
+ * the ' separators are optional.
+ *
+ * \return the board or an empty optional if the text is not a permutation of the 16 values.
+ */
+inline std::optional<Board> parse_board(std::string_view text) {
+  if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+    text.remove_prefix(2);
+
+  Board board = 0;
+  int digits = 0;
+  unsigned seen = 0;
+  for (char c : text) {
+    int value;
+    if (c == '\'')
+      continue;
+    else if (c >= '0' && c <= '9')
+      value = c - '0';
+    else if (c >= 'a' && c <= 'f')
+      value = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+      value = c - 'A' + 10;
+    else
+      return {};
+
+    if (++digits > 16 || (seen & (1u << value)))
+      return {};
+    seen |= 1u << value;
+    board = (board << 4) | value;
+  }
+
+  if (digits != 16)
+    return {};
+
+  return {board};
+}
+
+/**
+ * parse_tiles reads a board written as the list of its 16 tiles in decimal, from the top left
+ * corner and row by row, with 0 for the hole. The tiles are separated by spaces, tabs or commas.
+ *
+ * \return the board or an empty optional if the text is not a permutation of the 16 values.
+ */
+inline std::optional<Board> parse_tiles(std::string_view text) {
+  Board board = 0;
+  int tiles = 0;
+  unsigned seen = 0;
+  std::size_t i = 0;
+  while (i < text.size()) {
+    if (text[i] == ' ' || text[i] == '\t' || text[i] == ',') {
+      i++;
+      continue;
+    }
+
+    int value = 0;
+    int digits = 0;
+    for (; i < text.size() && text[i] >= '0' && text[i] <= '9' && digits < 3; i++, digits++)
+      value = value * 10 + (text[i] - '0');
+    if (digits == 0 || value > 15 || (i < text.size() && text[i] != ' ' && text[i] != '\t' && text[i] != ','))
+      return {};
+
+    if (++tiles > 16 || (seen & (1u << value)))
+      return {};
+    seen |= 1u << value;
+    board = (board << 4) | value;
+  }
+
+  if (tiles != 16)
+    return {};
+
+  return {board};
+}
+
+template <class Stream> Stream &operator<<(Stream &s, Direction d) {
+  switch (d) {
+  case Up:
+    s << "Up     ";
+    break;
+  case Right:
+    s << "Right  ";
+    break;
+  case Down:
+    s << "Down   ";
+    break;
+  case Left:
+    s << "Left   ";
+    break;
+  case Nothing:
+    s << "Nothing";
+    break;
+  }
+  return s;
+}
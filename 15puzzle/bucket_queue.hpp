@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * bucket_queue is a priority queue for small integer priorities. The values are kept in
+ * buckets indexed first by f and then by g, and every bucket is a LIFO stack, so push and
+ * pop are O(1) with no sifting.
+ *
+ * The top is the value with the smallest f. Between the values with the same f, the one
+ * with the biggest g is chosen (the deeper node, that is closer to a solution) and,
+ * between those, the last one pushed.
+ *
+ * The cursor of the smallest f only goes forward while the pushed values have an f that
+ * is not smaller than the top one, as it happens with consistent heuristics. Pushing a
+ * smaller f is allowed and moves the cursor back.
+ *
+ * \tparam T type of the stored values.
+ */
+template <typename T> class bucket_queue {
+public:
+  using value_type = T;
+
+  void push(uint32_t f, uint32_t g, const T &value) {
+    if (f >= levels_.size())
+      levels_.resize(f + 1);
+
+    level &l = levels_[f];
+    if (g >= l.buckets.size())
+      l.buckets.resize(g + 1);
+    l.buckets[g].push_back(value);
+
+    if (l.size == 0 || g > l.max_g)
+      l.max_g = g;
+    l.size++;
+
+    if (size_ == 0 || f < min_f_)
+      min_f_ = f;
+    size_++;
+  }
+
+  /**
+   * returns the value with the best priority. The queue must not be empty.
+   */
+  const T &top() const { return levels_[min_f_].buckets[levels_[min_f_].max_g].back(); }
+
+  /**
+   * returns the f of the top value.
+   */
+  uint32_t top_f() const { return min_f_; }
+
+  /**
+   * returns the g of the top value.
+   */
+  uint32_t top_g() const { return levels_[min_f_].max_g; }
+
+  void pop() {
+    level &l = levels_[min_f_];
+    l.buckets[l.max_g].pop_back();
+    l.size--;
+    size_--;
+
+    if (l.size != 0) {
+      while (l.buckets[l.max_g].empty())
+        l.max_g--;
+    } else if (size_ != 0) {
+      while (levels_[min_f_].size == 0)
+        min_f_++;
+    }
+  }
+
+  bool empty() const { return size_ == 0; }
+
+  std::size_t size() const { return size_; }
+
+  /**
+   * calls f(f, g, value) for every value, in the order they would be popped. The queue is
+   * not modified.
+   */
+  template <typename F> void for_each(F &&f) const {
+    for (std::size_t i = min_f_; i < levels_.size(); i++) {
+      const level &l = levels_[i];
+      if (l.size == 0)
+        continue;
+      for (std::size_t g = l.max_g + 1; g-- > 0;)
+        for (auto it = l.buckets[g].rbegin(); it != l.buckets[g].rend(); ++it)
+          f(static_cast<uint32_t>(i), static_cast<uint32_t>(g), *it);
+    }
+  }
+
+  /**
+   * removes all the values, keeping the buckets allocated.
+   */
+  void clear() {
+    for (auto &l : levels_) {
+      for (auto &b : l.buckets)
+        b.clear();
+      l.size = 0;
+      l.max_g = 0;
+    }
+    min_f_ = 0;
+    size_ = 0;
+  }
+
+private:
+  struct level {
+    std::vector<std::vector<T>> buckets;
+    std::size_t size = 0;
+    uint32_t max_g = 0;
+  };
+
+  std::vector<level> levels_;
+  uint32_t min_f_ = 0;
+  std::size_t size_ = 0;
+};
@@ -0,0 +1,318 @@
+#pragma once
+
+#include "board.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+
+/**
+ * checkpoint_node is a node of the search as it is stored in a checkpoint file.
+ */
+struct checkpoint_node {
+  Board board;
+  uint32_t parent;
+  uint16_t moves;
+  uint8_t direction;
+  /**
+   * pruning_state is the state of move_pruning of the node.
+   */
+  uint8_t pruning_state;
+};
+
+static_assert(sizeof(checkpoint_node) == 16);
+
+/**
+ * checkpoint_open_entry is an element of the open list: the index of its node and its
+ * priority.
+ */
+struct checkpoint_open_entry {
+  uint32_t node;
+  uint16_t f;
+  uint16_t g;
+};
+
+static_assert(sizeof(checkpoint_open_entry) == 8);
+
+/**
+ * checkpoint_info describes the search that wrote a checkpoint, so it is only resumed by the
+ * same search, and the size of its sections.
+ */
+struct checkpoint_info {
+  Board initial_board;
+  uint64_t expanded;
+  uint64_t nodes;
+  uint64_t open;
+  uint64_t closed;
+  /**
+   * heuristic is the name of the heuristic, ended with zeros.
+   */
+  char heuristic[32];
+  /**
+   * has_closed_set is 1 when the search keeps a closed set, even if it is empty.
+   */
+  uint8_t has_closed_set;
+  uint8_t reserved[7];
+};
+
+/**
+ * checkpoint is a snapshot of an A* search in a file, mapped read only in memory.
+ *
+ * The file has a header page and then the sections, one after the other, with the packed
+ * boards as they are in memory:
+ *
+ * - the nodes, in the order of their handles, so the parents are the same handles;
+ * - the open list, in the order it would be popped;
+ * - the boards of the closed set and then the moves of each one.
+ *
+ * save writes the file with another name and renames it at the end, so the checkpoint in
+ * the path is always a complete one, even if the process dies while writing the next one.
+ */
+class checkpoint {
+public:
+  static constexpr char magic[8] = {'1', '5', 'C', 'K', 'P', 'T', 0, 1};
+  static constexpr std::size_t header_size = 4096;
+  static constexpr std::size_t buffer_size = std::size_t{1} << 20;
+
+  checkpoint(const checkpoint &) = delete;
+  checkpoint(checkpoint &&other) : data_{other.data_}, size_{other.size_}, info_{other.info_} {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+
+  checkpoint &operator=(const checkpoint &) = delete;
+  checkpoint &operator=(checkpoint &&other) {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(info_, other.info_);
+    return *this;
+  }
+
+  ~checkpoint() {
+    if (data_ != nullptr)
+      munmap(const_cast<uint8_t *>(data_), size_);
+  }
+
+  /**
+   * open maps a checkpoint file in memory.
+   *
+   * \return the checkpoint or an empty optional if the file cannot be mapped or is not a
+   *         complete checkpoint. errno describes the problem.
+   */
+  static std::optional<checkpoint> open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return {};
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < header_size) {
+      ::close(fd);
+      errno = EINVAL;
+      return {};
+    }
+
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+      return {};
+
+    checkpoint c{static_cast<const uint8_t *>(data), static_cast<std::size_t>(st.st_size)};
+    std::memcpy(&c.info_, c.data_ + sizeof(magic), sizeof(checkpoint_info));
+    if (std::memcmp(c.data_, magic, sizeof(magic)) != 0 || file_size(c.info_) != c.size_ || c.info_.heuristic[sizeof(c.info_.heuristic) - 1] != 0) {
+      errno = EINVAL;
+      return {};
+    }
+
+    return {std::move(c)};
+  }
+
+  /**
+   * save writes a checkpoint. The counts of info must be the number of values each function
+   * gives.
+   *
+   * \param nodes called with the index of every node, it returns the checkpoint_node.
+   * \param for_each_open called with a function that takes the f, the g and the node of every
+   *                      element of the open list.
+   * \param for_each_closed called with a function that takes the board and the moves of every
+   *                        element of the closed set. It is called twice.
+   * \return false if the file cannot be written. errno describes the problem.
+   */
+  template <class Nodes, class ForEachOpen, class ForEachClosed>
+  static bool save(const std::string &path, const checkpoint_info &info, Nodes &&nodes, ForEachOpen &&for_each_open, ForEachClosed &&for_each_closed) {
+    std::string temporary = path + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr)
+      return false;
+
+    auto buffer = std::make_unique<char[]>(buffer_size);
+    std::setvbuf(file, buffer.get(), _IOFBF, buffer_size);
+
+    bool ok = true;
+    auto write = [&](const void *value, std::size_t size) { ok = ok && std::fwrite(value, 1, size, file) == size; };
+
+    uint8_t header[header_size] = {};
+    std::memcpy(header, magic, sizeof(magic));
+    std::memcpy(header + sizeof(magic), &info, sizeof(info));
+    write(header, sizeof(header));
+
+    for (uint64_t i = 0; i < info.nodes; i++) {
+      checkpoint_node n = nodes(i);
+      write(&n, sizeof(n));
+    }
+
+    for_each_open([&](uint32_t f, uint32_t g, uint32_t node) {
+      checkpoint_open_entry e{node, static_cast<uint16_t>(f), static_cast<uint16_t>(g)};
+      write(&e, sizeof(e));
+    });
+
+    for_each_closed([&](Board b, uint16_t) { write(&b, sizeof(b)); });
+    for_each_closed([&](Board, uint16_t moves) { write(&moves, sizeof(moves)); });
+
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+      int error = errno;
+      std::remove(temporary.c_str());
+      errno = error;
+      return false;
+    }
+
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+  }
+
+  const checkpoint_info &info() const { return info_; }
+
+  std::string_view heuristic() const { return info_.heuristic; }
+
+  checkpoint_node node(uint64_t i) const { return read<checkpoint_node>(nodes_offset() + i * sizeof(checkpoint_node)); }
+
+  checkpoint_open_entry open_entry(uint64_t i) const { return read<checkpoint_open_entry>(open_offset() + i * sizeof(checkpoint_open_entry)); }
+
+  Board closed_board(uint64_t i) const { return read<Board>(closed_offset() + i * sizeof(Board)); }
+
+  uint16_t closed_moves(uint64_t i) const { return read<uint16_t>(closed_offset() + info_.closed * sizeof(Board) + i * sizeof(uint16_t)); }
+
+  std::size_t bytes() const { return size_; }
+
+private:
+  checkpoint(const uint8_t *data, std::size_t size) : data_{data}, size_{size} {}
+
+  static uint64_t file_size(const checkpoint_info &info) {
+    return header_size + info.nodes * sizeof(checkpoint_node) + info.open * sizeof(checkpoint_open_entry) + info.closed * (sizeof(Board) + sizeof(uint16_t));
+  }
+
+  uint64_t nodes_offset() const { return header_size; }
+
+  uint64_t open_offset() const { return nodes_offset() + info_.nodes * sizeof(checkpoint_node); }
+
+  uint64_t closed_offset() const { return open_offset() + info_.open * sizeof(checkpoint_open_entry); }
+
+  template <class T> T read(uint64_t offset) const {
+    T value;
+    std::memcpy(&value, data_ + offset, sizeof(T));
+    return value;
+  }
+
+  const uint8_t *data_;
+  std::size_t size_;
+  checkpoint_info info_{};
+};
+
+/**
+ * background_checkpoint writes checkpoints from a child process. fork gives the child a copy
+ * on write snapshot of the search, so the search only stops while the pages are shared and
+ * goes on while the child writes the file. Only one child runs at a time.
+ *
+ * The child allocates memory and writes with stdio, so the other threads of the process must be
+ * paused, not holding any lock, when a checkpoint is started.
+ */
+class background_checkpoint {
+public:
+  background_checkpoint() = default;
+  background_checkpoint(const background_checkpoint &) = delete;
+  background_checkpoint &operator=(const background_checkpoint &) = delete;
+
+  ~background_checkpoint() { wait(); }
+
+  /**
+   * start runs save in a child process. It does nothing if the previous child is still
+   * running.
+   *
+   * \param save the function that writes the checkpoint. It returns false on errors.
+   * \return false if the checkpoint was not started.
+   */
+  template <class Save> bool start(Save &&save) {
+    if (running())
+      return false;
+
+    pid_t pid = fork();
+    if (pid < 0)
+      return false;
+
+    if (pid == 0) {
+      // _exit, so the child does not flush the buffers of the parent or run its destructors
+      _exit(save() ? 0 : 1);
+    }
+
+    child_ = pid;
+    return true;
+  }
+
+  /**
+   * running checks if the child is still writing. When it has finished, it records its result.
+   */
+  bool running() {
+    if (child_ <= 0)
+      return false;
+
+    int status;
+    if (waitpid(child_, &status, WNOHANG) == 0)
+      return true;
+
+    finish(status);
+    return false;
+  }
+
+  /**
+   * wait waits for the child, if any.
+   *
+   * \return false if the last checkpoint could not be written.
+   */
+  bool wait() {
+    if (child_ > 0) {
+      int status;
+      if (waitpid(child_, &status, 0) == child_)
+        finish(status);
+      else
+        child_ = 0;
+    }
+    return last_succeeded_;
+  }
+
+  /**
+   * returns the number of checkpoints written.
+   */
+  uint64_t written() const { return written_; }
+
+private:
+  void finish(int status) {
+    child_ = 0;
+    last_succeeded_ = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (last_succeeded_)
+      written_++;
+  }
+
+  pid_t child_ = 0;
+  bool last_succeeded_ = true;
+  uint64_t written_ = 0;
+};
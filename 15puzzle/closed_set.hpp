@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+/**
+ * board_hash mixes the bits of a board with the murmur3 finalizer. The boards are permutations,
+ * so their low bits alone are a bad hash.
+ */
+inline uint64_t board_hash(uint64_t key) {
+  key ^= key >> 33;
+  key *= 0xff51'afd7'ed55'8ccdull;
+  key ^= key >> 33;
+  key *= 0xc4ce'b9fe'1a85'ec53ull;
+  key ^= key >> 33;
+  return key;
+}
+
+/**
+ * board_hash_map is a flat open addressing hash table keyed by a 64 bit board.
+ *
+ * The table is split in groups of 8 slots. Every slot has a control byte with 7
+ * bits of the hash (or the empty mark) so a whole group is checked with a few
+ * arithmetic operations on a 64 bit word (SWAR) before touching the keys. There
+ * are no deletions: a group with an empty slot ends the probe sequence.
+ *
+ * The table doubles its capacity when the load factor reaches 7/8. If growing
+ * would exceed the memory cap, the table is filled up to 15/16 of its capacity
+ * and then inserts fail with insert_result::full.
+ *
+ * \tparam Value type of the value stored for each board.
+ */
+template <typename Value> class board_hash_map {
+public:
+  using key_type = uint64_t;
+  using value_type = Value;
+
+  enum class insert_result { inserted, improved, not_improved, full };
+
+  static constexpr std::size_t group_size = 8;
+  static constexpr std::size_t bytes_per_slot = 1 + sizeof(key_type) + sizeof(value_type);
+
+  /**
+   * \param max_bytes maximum number of bytes the table can use.
+   * \param initial_capacity number of slots reserved at the start. It is rounded up to a power of two.
+   */
+  explicit board_hash_map(std::size_t max_bytes = std::numeric_limits<std::size_t>::max(), std::size_t initial_capacity = 1024) : max_bytes_{max_bytes} {
+    std::size_t capacity = group_size;
+    while (capacity < initial_capacity && (capacity * 2) * bytes_per_slot <= max_bytes_)
+      capacity *= 2;
+    allocate(capacity);
+  }
+
+  /**
+   * find returns a pointer to the value stored for the board or nullptr if the board is not
+   * in the table. The pointer is valid until the next insertion.
+   */
+  const value_type *find(key_type key) const {
+    std::size_t slot = find_slot(key);
+    return slot == npos ? nullptr : &values_[slot];
+  }
+
+  value_type *find(key_type key) {
+    std::size_t slot = find_slot(key);
+    return slot == npos ? nullptr : &values_[slot];
+  }
+
+  /**
+   * insert_or_assign stores the value for the board, replacing the previous one if any.
+   */
+  insert_result insert_or_assign(key_type key, value_type value) {
+    return insert_if(key, value, [](const value_type &, const value_type &) { return true; });
+  }
+
+  /**
+   * insert_or_improve stores the value if the board is not in the table or if the stored
+   * value is bigger than the new one. It is used to keep the best g of each board.
+   */
+  insert_result insert_or_improve(key_type key, value_type value) {
+    return insert_if(key, value, [](const value_type &stored, const value_type &v) { return v < stored; });
+  }
+
+  /**
+   * calls f(board, value) for every element in the table.
+   */
+  template <typename F> void for_each(F &&f) const {
+    for (std::size_t i = 0; i < capacity_; i++)
+      if (ctrl_[i] != empty)
+        f(keys_[i], values_[i]);
+  }
+
+  void clear() {
+    std::fill(ctrl_.begin(), ctrl_.end(), empty);
+    size_ = 0;
+  }
+
+  std::size_t size() const { return size_; }
+
+  std::size_t capacity() const { return capacity_; }
+
+  std::size_t bytes() const { return capacity_ * bytes_per_slot; }
+
+  double load_factor() const { return static_cast<double>(size_) / capacity_; }
+
+private:
+  static constexpr uint8_t empty = 0x80;
+  static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+  static constexpr uint64_t lsb = 0x0101'0101'0101'0101ull;
+  static constexpr uint64_t msb = 0x8080'8080'8080'8080ull;
+
+  static uint8_t tag_of(uint64_t h) { return static_cast<uint8_t>(h >> 57); }
+
+  uint64_t load_group(std::size_t group) const {
+    uint64_t word;
+    std::memcpy(&word, &ctrl_[group * group_size], sizeof(word));
+    return word;
+  }
+
+  /**
+   * returns a mask with the high bit set in each byte of the group equal to tag. It can
+   * have false positives, so the keys must be checked.
+   */
+  static uint64_t match(uint64_t group, uint8_t tag) {
+    uint64_t x = group ^ (lsb * tag);
+    return (x - lsb) & ~x & msb;
+  }
+
+  static uint64_t match_empty(uint64_t group) { return group & msb; }
+
+  static std::size_t first_byte(uint64_t mask) { return __builtin_ctzll(mask) / 8; }
+
+  std::size_t find_slot(key_type key) const {
+    uint64_t h = board_hash(key);
+    uint8_t tag = tag_of(h);
+    std::size_t group = h & group_mask_;
+
+    while (true) {
+      uint64_t ctrl = load_group(group);
+      for (uint64_t m = match(ctrl, tag); m; m &= m - 1) {
+        std::size_t slot = group * group_size + first_byte(m);
+        if (keys_[slot] == key)
+          return slot;
+      }
+      if (match_empty(ctrl))
+        return npos;
+      group = (group + 1) & group_mask_;
+    }
+  }
+
+  template <typename ShouldReplace> insert_result insert_if(key_type key, value_type value, ShouldReplace &&should_replace) {
+    if (needs_to_grow() && can_grow())
+      grow();
+
+    uint64_t h = board_hash(key);
+    uint8_t tag = tag_of(h);
+    std::size_t group = h & group_mask_;
+
+    while (true) {
+      uint64_t ctrl = load_group(group);
+      for (uint64_t m = match(ctrl, tag); m; m &= m - 1) {
+        std::size_t slot = group * group_size + first_byte(m);
+        if (keys_[slot] == key) {
+          if (!should_replace(values_[slot], value))
+            return insert_result::not_improved;
+          values_[slot] = value;
+          return insert_result::improved;
+        }
+      }
+      if (uint64_t e = match_empty(ctrl)) {
+        // When the table cannot grow, it is filled up to 15/16 of its capacity
+        if ((size_ + 1) * 16 > capacity_ * 15)
+          return insert_result::full;
+        std::size_t slot = group * group_size + first_byte(e);
+        ctrl_[slot] = tag;
+        keys_[slot] = key;
+        values_[slot] = value;
+        size_++;
+        return insert_result::inserted;
+      }
+      group = (group + 1) & group_mask_;
+    }
+  }
+
+  bool needs_to_grow() const { return (size_ + 1) * 8 > capacity_ * 7; }
+
+  bool can_grow() const { return capacity_ * 2 * bytes_per_slot <= max_bytes_; }
+
+  void allocate(std::size_t capacity) {
+    capacity_ = capacity;
+    group_mask_ = capacity / group_size - 1;
+    ctrl_.assign(capacity, empty);
+    keys_.assign(capacity, 0);
+    values_.assign(capacity, value_type{});
+  }
+
+  void grow() {
+    std::vector<uint8_t> old_ctrl = std::move(ctrl_);
+    std::vector<key_type> old_keys = std::move(keys_);
+    std::vector<value_type> old_values = std::move(values_);
+
+    allocate(capacity_ * 2);
+
+    for (std::size_t i = 0; i < old_ctrl.size(); i++) {
+      if (old_ctrl[i] == empty)
+        continue;
+
+      uint64_t h = board_hash(old_keys[i]);
+      std::size_t group = h & group_mask_;
+      uint64_t e;
+      while (!(e = match_empty(load_group(group))))
+        group = (group + 1) & group_mask_;
+
+      std::size_t slot = group * group_size + first_byte(e);
+      ctrl_[slot] = tag_of(h);
+      keys_[slot] = old_keys[i];
+      values_[slot] = old_values[i];
+    }
+  }
+
+  std::size_t max_bytes_;
+  std::size_t capacity_ = 0;
+  std::size_t group_mask_ = 0;
+  std::size_t size_ = 0;
+  std::vector<uint8_t> ctrl_;
+  std::vector<key_type> keys_;
+  std::vector<value_type> values_;
+};
+
+/**
+ * closed_set stores the best number of moves found for every expanded board.
+ */
+using closed_set = board_hash_map<uint16_t>;
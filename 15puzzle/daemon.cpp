@@ -0,0 +1,337 @@
+#include "board.hpp"
+#include "heuristic.hpp"
+#include "ida.hpp"
+#include "pattern_database.hpp"
+#include "search_result.hpp"
+#include "solver_protocol.hpp"
+#include "unix_socket.hpp"
+
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <poll.h>
+#include <signal.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * daemon_options are the parameters of the daemon read from the command line.
+ */
+struct daemon_options {
+  std::string socket_path = "/tmp/15puzzle.sock";
+  unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+  /**
+   * max_nodes and max_milliseconds are the limits of every request. A request can ask for
+   * smaller ones, never for bigger ones.
+   */
+  uint64_t max_nodes = ida_star<manhattan_heuristic>::unlimited;
+  uint64_t max_milliseconds = 10000;
+};
+
+volatile sig_atomic_t stop_requested = 0;
+
+void request_stop(int) { stop_requested = 1; }
+
+/**
+ * connection is a client of the daemon. The main thread reads its requests and the workers
+ * write the responses, so it lives until the last of its requests is answered.
+ */
+struct connection {
+  explicit connection(int fd) : fd{fd} {}
+  connection(const connection &) = delete;
+  connection &operator=(const connection &) = delete;
+  ~connection() { ::close(fd); }
+
+  /**
+   * send writes a line. The errors are ignored, the main thread sees the closed socket.
+   */
+  void send(const std::string &line) {
+    std::lock_guard lock{output_mutex};
+    send_all(fd, line);
+  }
+
+  const int fd;
+  line_reader input;
+  std::mutex output_mutex;
+};
+
+struct solve_job {
+  std::shared_ptr<connection> client;
+  solve_request request;
+};
+
+/**
+ * job_queue is the queue of the requests waiting for a worker.
+ */
+class job_queue {
+public:
+  void push(solve_job job) {
+    {
+      std::lock_guard lock{mutex_};
+      if (closed_)
+        return;
+      jobs_.push_back(std::move(job));
+    }
+    ready_.notify_one();
+  }
+
+  /**
+   * pop waits for a job.
+   *
+   * \return the job or an empty optional when the queue is closed.
+   */
+  std::optional<solve_job> pop() {
+    std::unique_lock lock{mutex_};
+    ready_.wait(lock, [&] { return closed_ || !jobs_.empty(); });
+    if (closed_)
+      return {};
+    solve_job job = std::move(jobs_.front());
+    jobs_.pop_front();
+    return {std::move(job)};
+  }
+
+  /**
+   * close drops the jobs that are waiting and wakes up the workers.
+   */
+  void close() {
+    {
+      std::lock_guard lock{mutex_};
+      closed_ = true;
+      jobs_.clear();
+    }
+    ready_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<solve_job> jobs_;
+  bool closed_ = false;
+};
+
+/**
+ * serve answers the requests of the clients of the socket until it gets SIGINT or SIGTERM.
+ *
+ * The heuristic and its tables are loaded once and every worker keeps its IDA* from a request to
+ * the next one, so a request only pays for its search. The main thread accepts the clients and
+ * reads the requests of all of them with poll; the workers take the requests in the order they
+ * arrive and answer them as soon as they finish, so the requests of a client can be pipelined.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> int serve(const daemon_options &options, const Heuristic &heuristic) {
+  // The heuristics that build their tables on first use build them now, not in the first request
+  heuristic.evaluate(solved_board);
+
+  int listener = listen_unix(options.socket_path);
+  if (listener < 0) {
+    std::cerr << "Cannot listen on " << options.socket_path << ": " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+
+  job_queue jobs;
+  std::atomic<bool> stopping = false;
+  std::atomic<uint64_t> requests = 0;
+  std::atomic<uint64_t> solved = 0;
+  std::atomic<uint64_t> expanded = 0;
+
+  auto start_time = std::chrono::steady_clock::now();
+  laparca::thread_pool pool(options.threads, [&]() {
+    ida_star<Heuristic> ida{heuristic};
+
+    while (auto job = jobs.pop()) {
+      const solve_request &request = job->request;
+      const uint64_t max_nodes = request.max_nodes == 0 ? options.max_nodes : std::min(request.max_nodes, options.max_nodes);
+      const uint64_t max_milliseconds = request.max_milliseconds == 0 ? options.max_milliseconds : std::min(request.max_milliseconds, options.max_milliseconds);
+
+      auto search_start = std::chrono::steady_clock::now();
+      auto deadline = search_start + std::chrono::milliseconds{max_milliseconds};
+      bool timed_out = false;
+      auto result = ida.solve(request.board, max_nodes, [](int, uint64_t) {}, [&] {
+        timed_out = std::chrono::steady_clock::now() >= deadline;
+        return timed_out || stopping;
+      });
+
+      solve_response response;
+      response.board = request.board;
+      response.expanded = result.expanded;
+      response.microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - search_start).count();
+      if (result.solved) {
+        response.status = solve_status::solved;
+        response.moves = std::move(result.moves);
+      } else if (result.expanded >= max_nodes) {
+        response.status = solve_status::node_limit;
+      } else {
+        response.status = timed_out ? solve_status::time_limit : solve_status::cancelled;
+      }
+
+      requests++;
+      expanded += result.expanded;
+      if (result.solved)
+        solved++;
+      job->client->send(format_response(response));
+    }
+  });
+
+  std::cout << "Listening on " << options.socket_path << " with " << options.threads << " threads" << std::endl;
+
+  std::vector<std::shared_ptr<connection>> clients;
+  std::vector<pollfd> polled;
+  std::string line;
+  while (!stop_requested) {
+    polled.assign(1, {listener, POLLIN, 0});
+    for (auto &c : clients)
+      polled.push_back({c->fd, POLLIN, 0});
+
+    // The timeout only bounds the time to see a signal that arrives between the check and poll
+    if (poll(polled.data(), polled.size(), 200) < 0) {
+      if (errno == EINTR)
+        continue;
+      std::cerr << "Cannot wait for the clients: " << std::strerror(errno) << std::endl;
+      break;
+    }
+
+    for (std::size_t i = 1; i < polled.size(); i++) {
+      if (polled[i].revents == 0)
+        continue;
+
+      auto &client = clients[i - 1];
+      bool open = client->input.read(client->fd);
+      while (client->input.next(line)) {
+        if (line.empty())
+          continue;
+        auto request = parse_request(line);
+        if (!request)
+          client->send(format_error(line, "invalid request"));
+        else if (!is_board_solvable(request->board))
+          client->send(format_error(line, "the board cannot be solved"));
+        else
+          jobs.push({client, *request});
+      }
+
+      // The pending requests keep the connection until they are answered
+      if (!open)
+        client.reset();
+    }
+    clients.erase(std::remove(clients.begin(), clients.end(), nullptr), clients.end());
+
+    if (polled[0].revents & POLLIN) {
+      int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+      if (fd >= 0)
+        clients.push_back(std::make_shared<connection>(fd));
+    }
+  }
+
+  // The searches that are running end at their next check
+  stopping = true;
+  jobs.close();
+  pool.join();
+  clients.clear();
+  ::close(listener);
+  ::unlink(options.socket_path.c_str());
+  std::chrono::duration<double> total = std::chrono::steady_clock::now() - start_time;
+
+  std::cout << "Requests  : " << requests << std::endl;
+  std::cout << "Solved    : " << solved << std::endl;
+  std::cout << "Expanded  : " << expanded << std::endl;
+  std::cout << "Duration  : " << total.count() << "; " << std::setprecision(10) << requests / total.count() << " requests / s" << std::endl;
+
+  return 0;
+}
+
+int main(int argc, const char **argv) {
+  daemon_options options;
+  std::optional<pattern_database> pdb;
+  std::string_view heuristic_name = "manhattan";
+
+  using namespace std::literals;
+
+  for (int arg = 1; arg < argc; arg++) {
+    if ("--socket"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.socket_path = argv[++arg];
+      } else {
+        std::cerr << "No socket path found" << std::endl;
+        return 1;
+      }
+    } else if ("--threads"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.threads = std::stoul(argv[++arg]);
+        if (options.threads == 0) {
+          std::cerr << "Invalid number of threads " << argv[arg] << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No number of threads found" << std::endl;
+        return 1;
+      }
+    } else if ("--max-nodes"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.max_nodes = std::stoull(argv[++arg]);
+      } else {
+        std::cerr << "No number of nodes found" << std::endl;
+        return 1;
+      }
+    } else if ("--max-ms"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.max_milliseconds = std::stoull(argv[++arg]);
+      } else {
+        std::cerr << "No time limit found" << std::endl;
+        return 1;
+      }
+    } else if ("--heuristic"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        heuristic_name = argv[++arg];
+      } else {
+        std::cerr << "No heuristic found" << std::endl;
+        return 1;
+      }
+    } else if ("--pdb"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        pdb = pattern_database::open(argv[++arg]);
+        if (!pdb) {
+          std::cerr << "Cannot load the pattern database " << argv[arg] << ": " << std::strerror(errno) << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No pattern database found" << std::endl;
+        return 1;
+      }
+    } else {
+      std::cerr << "Unknown option " << argv[arg] << std::endl;
+      return 1;
+    }
+  }
+
+  // Without SA_RESTART, the signals interrupt poll and the loop sees them at once
+  struct sigaction action;
+  action.sa_handler = request_stop;
+  action.sa_flags = 0;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  if (pdb)
+    return serve(options, *pdb);
+
+  if (auto status = with_heuristic(heuristic_name, [&](const auto &heuristic) { return serve(options, heuristic); }))
+    return *status;
+
+  std::cerr << "Unknown heuristic " << heuristic_name << std::endl;
+  return 1;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "board.hpp"
+#include "bucket_queue.hpp"
+#include "closed_set.hpp"
+#include "heuristic.hpp"
+#include "node_arena.hpp"
+#include "search_result.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+/**
+ * manhattan_operators is the operator selection table of the Manhattan distance: the
+ * change of the heuristic of every move, known from the position of the hole, the direction
+ * and the moved tile without building the new board.
+ *
+ * delta[hole][direction][tile] is -1 or +1 for the legal moves, 0 for the others.
+ */
+struct manhattan_operators {
+  static constexpr std::array<std::array<std::array<int8_t, 16>, 4>, 16> delta = [] {
+    std::array<std::array<std::array<int8_t, 16>, 4>, 16> table{};
+    for (int hole = 0; hole < 16; hole++)
+      for (int d = 0; d < 4; d++) {
+        if (!playgroundcpp::board::can_move(hole, d))
+          continue;
+        int from = hole + playgroundcpp::board::offset[d];
+        for (int tile = 1; tile < 16; tile++)
+          table[hole][d][tile] = manhattan_heuristic::distance[tile][hole] - manhattan_heuristic::distance[tile][from];
+      }
+    return table;
+  }();
+};
+
+static_assert(manhattan_operators::delta[0][Up][12] == 1 && manhattan_operators::delta[0][Up][15] == -1);
+
+/**
+ * epea_star is an Enhanced Partial Expansion A* (Felner et al., "Partial-expansion A* with
+ * selective node generation"). A node is stored in the open list with a value F, that is its
+ * f when it is generated. When it is expanded, only the children whose f is F are generated;
+ * the parent goes back to the open list with the smallest f of the other children, and it is
+ * expanded again when that f is the best one. The children that are never the best option are
+ * never stored, so the open list and the nodes are several times smaller.
+ *
+ * With the Manhattan distance, manhattan_operators gives the f of the children before they are
+ * built. The other heuristics build the children to know their f, but they also store only the
+ * ones that are needed.
+ *
+ * Duplicates are detected with a closed set of the best g of every generated board.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> class epea_star {
+public:
+  static constexpr uint64_t unlimited = std::numeric_limits<uint64_t>::max();
+
+  explicit epea_star(const Heuristic &heuristic) : heuristic_{heuristic} {}
+
+  /**
+   * solve searches the moves that solve the board. result.expanded counts every expansion,
+   * also the ones of the nodes expanded again.
+   *
+   * \param max_nodes the search stops after expanding this number of nodes.
+   */
+  search_result solve(Board initial, uint64_t max_nodes = unlimited) {
+    search_result result;
+    nodes_.clear();
+    open_.clear();
+    best_g_.clear();
+    reinserted_ = 0;
+    max_open_ = 0;
+    if (!is_board_solvable(initial))
+      return result;
+
+    uint16_t h = heuristic_.evaluate(initial);
+    open_.push(h, 0, nodes_.push_back({initial, no_node, 0, h, Nothing}));
+    best_g_.insert_or_assign(initial, 0);
+
+    while (!open_.empty()) {
+      const node_handle top = open_.top();
+      const uint32_t stored_f = open_.top_f();
+      open_.pop();
+      const node current = nodes_[top];
+
+      if (current.board == solved_board) {
+        result.solved = true;
+        for (node_handle n = top; nodes_[n].direction != Nothing; n = nodes_[n].parent)
+          result.moves.push_back(nodes_[n].direction);
+        std::reverse(result.moves.begin(), result.moves.end());
+        return result;
+      }
+
+      // The board was generated again with a shorter path
+      if (*best_g_.find(current.board) < current.g)
+        continue;
+
+      if (result.expanded >= max_nodes)
+        return result;
+      result.expanded++;
+
+      // The first expansion also generates the children with a smaller f, if the heuristic is not consistent
+      const uint32_t f = current.g + current.h;
+      const bool first = stored_f == f;
+      uint32_t next_f = std::numeric_limits<uint32_t>::max();
+      const int hole = get_hole_position(current.board);
+      for (int d = 0; d < 4; d++) {
+        if (!playgroundcpp::board::can_move(hole, d) || d == inverse(current.direction))
+          continue;
+
+        uint32_t child_f;
+        tile_move m;
+        if constexpr (uses_operator_table) {
+          const int tile = (current.board >> (4 * (hole + playgroundcpp::board::offset[d]))) & 0xf;
+          child_f = f + 1 + manhattan_operators::delta[hole][d][tile];
+        } else {
+          m = playgroundcpp::board::move_hole(current.board, hole, d);
+          child_f = current.g + 1 + heuristic_.update(current.h, m);
+        }
+
+        if (child_f != stored_f && !(first && child_f < stored_f)) {
+          if (child_f > stored_f)
+            next_f = std::min(next_f, child_f);
+          continue;
+        }
+
+        if constexpr (uses_operator_table)
+          m = playgroundcpp::board::move_hole(current.board, hole, d);
+
+        result.generated++;
+        const uint16_t g = current.g + 1;
+        if (best_g_.insert_or_improve(m.board, g) == closed_set::insert_result::not_improved)
+          continue;
+        open_.push(child_f, g, nodes_.push_back({m.board, top, g, static_cast<uint16_t>(child_f - g), static_cast<Direction>(d)}));
+      }
+
+      if (next_f != std::numeric_limits<uint32_t>::max()) {
+        open_.push(next_f, current.g, top);
+        reinserted_++;
+      }
+      max_open_ = std::max(max_open_, open_.size());
+    }
+
+    return result;
+  }
+
+  /**
+   * returns the number of nodes stored.
+   */
+  std::size_t nodes() const { return nodes_.size(); }
+
+  std::size_t bytes() const { return nodes_.bytes() + best_g_.bytes(); }
+
+  /**
+   * returns the number of times a node went back to the open list to be expanded again.
+   */
+  uint64_t reinserted() const { return reinserted_; }
+
+  /**
+   * returns the biggest size of the open list.
+   */
+  std::size_t max_open() const { return max_open_; }
+
+private:
+  static constexpr bool uses_operator_table = std::is_same_v<Heuristic, manhattan_heuristic>;
+
+  struct node {
+    Board board;
+    node_handle parent;
+    uint16_t g;
+    uint16_t h;
+    Direction direction;
+  };
+
+  const Heuristic &heuristic_;
+  node_arena<node> nodes_;
+  bucket_queue<node_handle> open_;
+  closed_set best_g_;
+  uint64_t reinserted_ = 0;
+  std::size_t max_open_ = 0;
+};
@@ -0,0 +1,128 @@
+#include "board.hpp"
+#include "external_search.hpp"
+#include "heuristic.hpp"
+#include "pattern_database.hpp"
+#include "search_result.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * solve runs the external memory search and prints the solution.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic>
+int solve(Board initial_board, uint64_t max_nodes, const std::string &directory, std::size_t buffer_bytes, const Heuristic &heuristic) {
+  external_search<Heuristic> search{heuristic, directory, buffer_bytes};
+
+  auto start_time = std::chrono::system_clock::now();
+  auto layer_time = start_time;
+  auto result = search.solve(initial_board, max_nodes, [&](int bound, int g, uint64_t boards, std::size_t runs) {
+    auto t = std::chrono::system_clock::now();
+    std::chrono::duration<double> diff = t - layer_time;
+    std::cout << "bound = " << bound << "; g = " << g << "; boards = " << boards << " (" << boards * frontier_writer::entry_size
+              << " bytes); runs = " << runs << "; duration = " << diff.count() << std::endl;
+    layer_time = t;
+  });
+  std::chrono::duration<double> total = std::chrono::system_clock::now() - start_time;
+
+  if (!result) {
+    std::cerr << "Cannot use the frontier files in " << directory << ": " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+
+  std::cout << "Expanded  : " << result->expanded << std::endl;
+  std::cout << "Generated : " << result->generated << std::endl;
+  std::cout << "Duration  : " << total.count() << "; " << std::setprecision(10) << result->expanded / total.count() << " nodes / s" << std::endl;
+
+  if (!result->solved) {
+    std::cout << "There isn't solution" << std::endl;
+  } else {
+    std::cout << "Moves     : " << result->moves.size() << std::endl;
+    std::cout << "Solution: " << result->moves << std::endl;
+  }
+
+  return 0;
+}
+
+int main(int argc, const char **argv) {
+  Board initial_board = default_board;
+  uint64_t max_nodes = external_search<manhattan_heuristic>::unlimited;
+  std::string directory = std::filesystem::temp_directory_path();
+  std::size_t buffer_bytes = std::size_t{256} << 20;
+  std::optional<pattern_database> pdb;
+  std::string_view heuristic_name = "manhattan";
+
+  using namespace std::literals;
+
+  for (int arg = 1; arg < argc; arg++) {
+    if ("--board"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        auto board = parse_board(argv[++arg]);
+        if (!board) {
+          std::cerr << "Invalid board " << argv[arg] << std::endl;
+          return 1;
+        }
+        initial_board = *board;
+      } else {
+        std::cerr << "No board found" << std::endl;
+        return 1;
+      }
+    } else if ("--dir"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        directory = argv[++arg];
+      } else {
+        std::cerr << "No directory found" << std::endl;
+        return 1;
+      }
+    } else if ("--buffer-mib"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        buffer_bytes = std::stoull(argv[++arg]) << 20;
+      } else {
+        std::cerr << "No buffer size found" << std::endl;
+        return 1;
+      }
+    } else if ("--heuristic"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        heuristic_name = argv[++arg];
+      } else {
+        std::cerr << "No heuristic found" << std::endl;
+        return 1;
+      }
+    } else if ("--pdb"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        pdb = pattern_database::open(argv[++arg]);
+        if (!pdb) {
+          std::cerr << "Cannot load the pattern database " << argv[arg] << ": " << std::strerror(errno) << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No pattern database found" << std::endl;
+        return 1;
+      }
+    } else
+      max_nodes = std::stoull(argv[arg]);
+  }
+
+  if (!is_board_solvable(initial_board)) {
+    std::cerr << "The board cannot be solved." << std::endl;
+    return 2;
+  }
+
+  if (pdb)
+    return solve(initial_board, max_nodes, directory, buffer_bytes, *pdb);
+
+  if (auto status = with_heuristic(heuristic_name, [&](const auto &heuristic) { return solve(initial_board, max_nodes, directory, buffer_bytes, heuristic); }))
+    return *status;
+
+  std::cerr << "Unknown heuristic " << heuristic_name << std::endl;
+  return 1;
+}
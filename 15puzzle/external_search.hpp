@@ -0,0 +1,480 @@
+#pragma once
+
+#include "board.hpp"
+#include "search_result.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+/**
+ * frontier_entry is a board of a frontier with the directions of the hole that lead back to
+ * the boards it was generated from, one bit per direction. Those moves are not generated
+ * again when the board is expanded.
+ */
+struct frontier_entry {
+  Board board;
+  uint8_t used;
+
+  bool operator<(const frontier_entry &other) const { return board < other.board; }
+};
+
+/**
+ * frontier_writer writes the entries of a frontier file: 9 bytes each, the board as it is in
+ * memory and the used directions, with no header. The writes go through a big buffer, so the
+ * file is written sequentially in large blocks.
+ */
+class frontier_writer {
+public:
+  static constexpr std::size_t entry_size = sizeof(Board) + 1;
+  static constexpr std::size_t buffer_size = std::size_t{1} << 20;
+
+  frontier_writer(const frontier_writer &) = delete;
+  frontier_writer(frontier_writer &&other) : file_{other.file_}, buffer_{std::move(other.buffer_)}, size_{other.size_} { other.file_ = nullptr; }
+
+  frontier_writer &operator=(const frontier_writer &) = delete;
+  frontier_writer &operator=(frontier_writer &&) = delete;
+
+  ~frontier_writer() {
+    if (file_ != nullptr)
+      std::fclose(file_);
+  }
+
+  /**
+   * create creates or truncates the file.
+   *
+   * \return the writer or an empty optional if the file cannot be created. errno describes
+   *         the problem.
+   */
+  static std::optional<frontier_writer> create(const std::string &path) {
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+      return {};
+    return {frontier_writer{file}};
+  }
+
+  /**
+   * write appends an entry. It is only counted if it is written; the search must stop on the
+   * first error, the file is not complete.
+   *
+   * \return false if the entry cannot be written. errno describes the problem.
+   */
+  bool write(const frontier_entry &e) {
+    char bytes[entry_size];
+    std::memcpy(bytes, &e.board, sizeof(Board));
+    bytes[sizeof(Board)] = e.used;
+    if (std::fwrite(bytes, 1, entry_size, file_) != entry_size)
+      return false;
+    size_++;
+    return true;
+  }
+
+  /**
+   * close flushes the buffer and closes the file.
+   *
+   * \return false if the file cannot be written. errno describes the problem.
+   */
+  bool close() {
+    // A write that failed before is not reported again by fclose
+    bool ok = !std::ferror(file_);
+    ok = std::fclose(file_) == 0 && ok;
+    file_ = nullptr;
+    return ok;
+  }
+
+  /**
+   * returns the number of entries written.
+   */
+  uint64_t size() const { return size_; }
+
+private:
+  explicit frontier_writer(std::FILE *file) : file_{file}, buffer_{new char[buffer_size]} { std::setvbuf(file_, buffer_.get(), _IOFBF, buffer_size); }
+
+  std::FILE *file_;
+  std::unique_ptr<char[]> buffer_;
+  uint64_t size_ = 0;
+};
+
+/**
+ * frontier_file maps a frontier file read only. The entries of the files written by the
+ * external search are sorted by board and unique, so they can be read in order to merge
+ * them or searched with a binary search. The pages are read by the kernel as they are
+ * needed, so only the parts of the file being used take memory.
+ */
+class frontier_file {
+public:
+  frontier_file(const frontier_file &) = delete;
+  frontier_file(frontier_file &&other) : data_{other.data_}, size_{other.size_} {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+
+  frontier_file &operator=(const frontier_file &) = delete;
+  frontier_file &operator=(frontier_file &&other) {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    return *this;
+  }
+
+  ~frontier_file() {
+    if (data_ != nullptr)
+      munmap(const_cast<uint8_t *>(data_), size_ * frontier_writer::entry_size);
+  }
+
+  /**
+   * open maps the file.
+   *
+   * \return the file or an empty optional if it cannot be mapped. errno describes the problem.
+   */
+  static std::optional<frontier_file> open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return {};
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size % frontier_writer::entry_size != 0) {
+      ::close(fd);
+      errno = EINVAL;
+      return {};
+    }
+
+    // An empty file cannot be mapped
+    if (st.st_size == 0) {
+      ::close(fd);
+      return {frontier_file{nullptr, 0}};
+    }
+
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+      return {};
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    return {frontier_file{static_cast<const uint8_t *>(data), st.st_size / frontier_writer::entry_size}};
+  }
+
+  frontier_entry operator[](uint64_t i) const {
+    frontier_entry e;
+    std::memcpy(&e.board, data_ + i * frontier_writer::entry_size, sizeof(Board));
+    e.used = data_[i * frontier_writer::entry_size + sizeof(Board)];
+    return e;
+  }
+
+  uint64_t size() const { return size_; }
+
+  /**
+   * returns if the board is in the file, that must be sorted.
+   */
+  bool contains(Board b) const {
+    uint64_t first = 0;
+    uint64_t last = size_;
+    while (first < last) {
+      uint64_t middle = first + (last - first) / 2;
+      Board current = (*this)[middle].board;
+      if (current == b)
+        return true;
+      if (current < b)
+        first = middle + 1;
+      else
+        last = middle;
+    }
+    return false;
+  }
+
+private:
+  frontier_file(const uint8_t *data, uint64_t size) : data_{data}, size_{size} {}
+
+  const uint8_t *data_;
+  uint64_t size_;
+};
+
+/**
+ * external_search is a breadth-first iterative deepening A* (Zhou and Hansen, "Breadth-first
+ * heuristic search") that keeps its frontiers on disk, for the boards that need more memory
+ * than there is RAM. Every iteration has a bound, like IDA*, and searches breadth first,
+ * one layer of g at a time, discarding the boards with g + h over the bound.
+ *
+ * The layers are frontier files of sorted unique boards. The children of a layer are
+ * collected in a buffer of a fixed size; when it is full, it is sorted and written as a run
+ * file. At the end of the layer, the runs are merged into the file of the next layer,
+ * removing the duplicates (their used directions are joined) and the boards that are in the
+ * layer before. The graph of the puzzle is bipartite, so a child cannot be in the layer of
+ * its parent, and the used directions avoid generating the parents again. Only the buffer
+ * and a cursor for each run are in memory.
+ *
+ * The solution is rebuilt backwards from the solved board, looking in every layer for a
+ * neighbour of the last board found.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> class external_search {
+public:
+  static constexpr uint64_t unlimited = std::numeric_limits<uint64_t>::max();
+
+  /**
+   * \param directory where the frontier files are written. They are removed when the search
+   *                  ends.
+   * \param buffer_bytes the memory of the buffer of the children.
+   */
+  external_search(const Heuristic &heuristic, std::string directory, std::size_t buffer_bytes)
+      : heuristic_{heuristic}, directory_{std::move(directory)}, buffer_entries_{std::max<std::size_t>(buffer_bytes / sizeof(frontier_entry), 1)} {}
+
+  ~external_search() { remove_files(); }
+
+  /**
+   * solve searches the moves that solve the board.
+   *
+   * \param max_nodes the search stops after expanding this number of nodes.
+   * \param on_layer called after writing every layer with the bound, the g of the layer, the
+   *                 number of boards of the layer and the number of run files merged.
+   * \return the result or an empty optional if a file cannot be written or read. errno
+   *         describes the problem.
+   */
+  template <class Observer> std::optional<search_result> solve(Board initial, uint64_t max_nodes, Observer &&on_layer) {
+    search_result result;
+    if (!is_board_solvable(initial))
+      return result;
+
+    if (initial == solved_board) {
+      result.solved = true;
+      return result;
+    }
+
+    int bound = heuristic_.evaluate(initial);
+    while (true) {
+      int next_bound = std::numeric_limits<int>::max();
+      bool finished = false;
+      if (!iterate(initial, bound, next_bound, max_nodes, result, finished, on_layer))
+        return {};
+      remove_files();
+
+      if (finished || next_bound == std::numeric_limits<int>::max())
+        return result;
+
+      bound = next_bound;
+    }
+  }
+
+  std::optional<search_result> solve(Board initial, uint64_t max_nodes = unlimited) {
+    return solve(initial, max_nodes, [](int, int, uint64_t, std::size_t) {});
+  }
+
+private:
+  std::string file_path(const char *kind, std::size_t index) {
+    std::string path = directory_ + "/15puzzle-" + std::to_string(getpid()) + "-" + kind + "-" + std::to_string(index) + ".bin";
+    files_.push_back(path);
+    return path;
+  }
+
+  void remove_files() {
+    for (const auto &path : files_)
+      std::remove(path.c_str());
+    files_.clear();
+  }
+
+  /**
+   * runs one iteration. It returns false on errors; finished is set when the search has
+   * ended: the board is solved or the nodes limit was reached.
+   */
+  template <class Observer>
+  bool iterate(Board initial, int bound, int &next_bound, uint64_t max_nodes, search_result &result, bool &finished, Observer &on_layer) {
+    std::vector<std::string> layers{file_path("layer", 0)};
+    {
+      auto writer = frontier_writer::create(layers[0]);
+      if (!writer || !writer->write({initial, 0}) || !writer->close())
+        return false;
+    }
+
+    for (int g = 0;; g++) {
+      auto layer = frontier_file::open(layers[g]);
+      if (!layer)
+        return false;
+      if (layer->size() == 0)
+        return true;
+
+      std::vector<frontier_entry> buffer;
+      buffer.reserve(buffer_entries_);
+      std::vector<std::string> runs;
+
+      for (uint64_t i = 0; i < layer->size(); i++) {
+        if (result.expanded >= max_nodes) {
+          finished = true;
+          return true;
+        }
+        result.expanded++;
+
+        const frontier_entry parent = (*layer)[i];
+        const int parent_h = heuristic_.evaluate(parent.board);
+        for (auto d : directions) {
+          if (parent.used & (1 << d))
+            continue;
+
+          auto m = move_tile(parent.board, d);
+          if (!m)
+            continue;
+
+          result.generated++;
+          int h = heuristic_.update(parent_h, *m);
+          if (g + 1 + h > bound) {
+            next_bound = std::min(next_bound, g + 1 + h);
+            continue;
+          }
+
+          if (m->board == solved_board) {
+            finished = true;
+            return rebuild(layers, g, parent.board, d, result);
+          }
+
+          buffer.push_back({m->board, static_cast<uint8_t>(1 << inverse(d))});
+          if (buffer.size() == buffer_entries_ && !write_run(buffer, runs))
+            return false;
+        }
+      }
+
+      if (!buffer.empty() && !write_run(buffer, runs))
+        return false;
+
+      layers.push_back(file_path("layer", g + 1));
+      uint64_t size = 0;
+      if (!merge(runs, g > 0 ? layers[g - 1] : std::string{}, layers[g + 1], size))
+        return false;
+      for (const auto &run : runs)
+        std::remove(run.c_str());
+
+      on_layer(bound, g + 1, size, runs.size());
+    }
+  }
+
+  /**
+   * sorts the buffer and writes it, without duplicates, as a new run file.
+   */
+  bool write_run(std::vector<frontier_entry> &buffer, std::vector<std::string> &runs) {
+    std::sort(buffer.begin(), buffer.end());
+    runs.push_back(file_path("run", run_count_++));
+    auto writer = frontier_writer::create(runs.back());
+    if (!writer)
+      return false;
+
+    for (std::size_t i = 0; i < buffer.size();) {
+      frontier_entry e = buffer[i++];
+      for (; i < buffer.size() && buffer[i].board == e.board; i++)
+        e.used |= buffer[i].used;
+      if (!writer->write(e))
+        return false;
+    }
+
+    buffer.clear();
+    return writer->close();
+  }
+
+  /**
+   * merges the sorted runs into the next layer, joining the duplicates and discarding the
+   * boards that are in the previous layer, that is read at the same time.
+   */
+  bool merge(const std::vector<std::string> &runs, const std::string &previous_path, const std::string &output_path, uint64_t &size) {
+    std::vector<frontier_file> files;
+    for (const auto &run : runs) {
+      auto file = frontier_file::open(run);
+      if (!file)
+        return false;
+      files.push_back(std::move(*file));
+    }
+
+    std::optional<frontier_file> previous;
+    if (!previous_path.empty() && !(previous = frontier_file::open(previous_path)))
+      return false;
+    uint64_t previous_index = 0;
+
+    auto writer = frontier_writer::create(output_path);
+    if (!writer)
+      return false;
+
+    // The heap has the next board of every run that has not been consumed
+    using cursor = std::pair<Board, std::size_t>;
+    std::priority_queue<cursor, std::vector<cursor>, std::greater<cursor>> heap;
+    std::vector<uint64_t> positions(files.size(), 0);
+    for (std::size_t i = 0; i < files.size(); i++)
+      if (files[i].size() > 0)
+        heap.push({files[i][0].board, i});
+
+    while (!heap.empty()) {
+      frontier_entry e{heap.top().first, 0};
+      while (!heap.empty() && heap.top().first == e.board) {
+        std::size_t run = heap.top().second;
+        heap.pop();
+        e.used |= files[run][positions[run]].used;
+        if (++positions[run] < files[run].size())
+          heap.push({files[run][positions[run]].board, run});
+      }
+
+      if (previous) {
+        while (previous_index < previous->size() && (*previous)[previous_index].board < e.board)
+          previous_index++;
+        if (previous_index < previous->size() && (*previous)[previous_index].board == e.board)
+          continue;
+      }
+
+      if (!writer->write(e))
+        return false;
+    }
+
+    size = writer->size();
+    return writer->close();
+  }
+
+  /**
+   * rebuilds the moves of the solution. The last move goes from the parent, that is in the
+   * layer g, to the solved board; the moves before are found going back through the layers.
+   */
+  bool rebuild(const std::vector<std::string> &layers, int g, Board parent, Direction last, search_result &result) {
+    result.solved = true;
+    result.moves.assign(g + 1, Nothing);
+    result.moves[g] = last;
+
+    Board current = parent;
+    for (int layer = g - 1; layer >= 0; layer--) {
+      auto file = frontier_file::open(layers[layer]);
+      if (!file)
+        return false;
+
+      bool found = false;
+      for (auto d : directions) {
+        auto previous = move(current, d);
+        if (previous && file->contains(*previous)) {
+          // The hole moved the other way to go from the previous board to the current one
+          result.moves[layer] = inverse(d);
+          current = *previous;
+          found = true;
+          break;
+        }
+      }
+
+      if (!found) {
+        errno = EINVAL;
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  const Heuristic &heuristic_;
+  const std::string directory_;
+  const std::size_t buffer_entries_;
+  std::vector<std::string> files_;
+  std::size_t run_count_ = 0;
+};
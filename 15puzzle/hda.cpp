@@ -0,0 +1,122 @@
+#include "board.hpp"
+#include "hda.hpp"
+#include "heuristic.hpp"
+#include "pattern_database.hpp"
+#include "search_result.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/**
+ * solve runs the HDA* and prints the solution.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> int solve(Board initial_board, uint64_t max_nodes, unsigned threads, std::size_t closed_max_bytes, const Heuristic &heuristic) {
+  hda_star<Heuristic> hda{heuristic, threads, closed_max_bytes};
+
+  auto start_time = std::chrono::system_clock::now();
+  auto result = hda.solve(initial_board, max_nodes);
+  std::chrono::duration<double> total = std::chrono::system_clock::now() - start_time;
+
+  std::cout << "Threads   : " << threads << std::endl;
+  std::cout << "Expanded  : " << result.expanded << std::endl;
+  std::cout << "Generated : " << result.generated << std::endl;
+  std::cout << "Duration  : " << total.count() << "; " << std::setprecision(10) << result.expanded / total.count() << " nodes / s" << std::endl;
+
+  if (!result.solved) {
+    std::cout << "There isn't solution" << std::endl;
+  } else {
+    std::cout << "Moves     : " << result.moves.size() << std::endl;
+    std::cout << "Solution: " << result.moves << std::endl;
+  }
+
+  return 0;
+}
+
+int main(int argc, const char **argv) {
+  Board initial_board = default_board;
+  uint64_t max_nodes = hda_star<manhattan_heuristic>::unlimited;
+  unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+  std::size_t closed_max_bytes = std::numeric_limits<std::size_t>::max();
+  std::optional<pattern_database> pdb;
+  std::string_view heuristic_name = "manhattan";
+
+  using namespace std::literals;
+
+  for (int arg = 1; arg < argc; arg++) {
+    if ("--board"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        auto board = parse_board(argv[++arg]);
+        if (!board) {
+          std::cerr << "Invalid board " << argv[arg] << std::endl;
+          return 1;
+        }
+        initial_board = *board;
+      } else {
+        std::cerr << "No board found" << std::endl;
+        return 1;
+      }
+    } else if ("--heuristic"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        heuristic_name = argv[++arg];
+      } else {
+        std::cerr << "No heuristic found" << std::endl;
+        return 1;
+      }
+    } else if ("--pdb"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        pdb = pattern_database::open(argv[++arg]);
+        if (!pdb) {
+          std::cerr << "Cannot load the pattern database " << argv[arg] << ": " << std::strerror(errno) << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No pattern database found" << std::endl;
+        return 1;
+      }
+    } else if ("--threads"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        threads = std::stoul(argv[++arg]);
+        if (threads == 0 || threads > std::numeric_limits<uint16_t>::max()) {
+          std::cerr << "Invalid number of threads " << argv[arg] << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No number of threads found" << std::endl;
+        return 1;
+      }
+    } else if ("--closed-set-mib"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        closed_max_bytes = std::stoull(argv[++arg]) << 20;
+      } else {
+        std::cerr << "No closed set size found" << std::endl;
+        return 1;
+      }
+    } else
+      max_nodes = std::stoull(argv[arg]);
+  }
+
+  if (!is_board_solvable(initial_board)) {
+    std::cerr << "The board cannot be solved." << std::endl;
+    return 2;
+  }
+
+  if (pdb)
+    return solve(initial_board, max_nodes, threads, closed_max_bytes, *pdb);
+
+  if (auto status = with_heuristic(heuristic_name, [&](const auto &heuristic) { return solve(initial_board, max_nodes, threads, closed_max_bytes, heuristic); }))
+    return *status;
+
+  std::cerr << "Unknown heuristic " << heuristic_name << std::endl;
+  return 1;
+}
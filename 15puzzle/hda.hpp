@@ -0,0 +1,307 @@
+#pragma once
+
+#include "board.hpp"
+#include "bucket_queue.hpp"
+#include "closed_set.hpp"
+#include "node_arena.hpp"
+#include "search_result.hpp"
+
+#include <laparca/chanel.hpp>
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * hda_star runs a hash distributed A* (HDA*). Every board has an owner worker, chosen by a
+ * hash of the board, and only the owner keeps it in its open and closed sets. The children
+ * generated by a worker are sent to their owners in batches through a laparca::chanelN per
+ * worker, so the workers never share a data structure.
+ *
+ * The first solution found is not always optimal, because the workers don't expand the nodes
+ * in global f order. It is kept as the incumbent and the workers prune every node with an f
+ * that is not smaller than its length. The search ends when all the workers have nothing to
+ * expand and there isn't any batch in the chanels, so the incumbent is optimal when the
+ * heuristic is admissible.
+ *
+ * Termination is detected with one counter: the number of busy workers plus the number of
+ * batches sent and not processed yet. A worker is counted as busy again before it processes a
+ * batch, so the counter only reaches zero when no work is left.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> class hda_star {
+public:
+  static constexpr uint64_t unlimited = std::numeric_limits<uint64_t>::max();
+
+  /**
+   * batch_size is the number of children that are sent together to the same worker.
+   */
+  static constexpr std::size_t batch_size = 64;
+
+  /**
+   * chanel_capacity is the number of batches a worker can have waiting to be processed.
+   */
+  static constexpr std::size_t chanel_capacity = 256;
+
+  /**
+   * \param workers number of threads of the search.
+   * \param closed_max_bytes memory available for the closed sets of all the workers.
+   */
+  hda_star(const Heuristic &heuristic, unsigned workers, std::size_t closed_max_bytes = std::numeric_limits<std::size_t>::max())
+      : heuristic_{heuristic}, closed_max_bytes_{closed_max_bytes}, workers_count_{std::max(workers, 1u)} {}
+
+  /**
+   * solve searches the moves that solve the board.
+   *
+   * \param max_nodes the search stops after expanding about this number of nodes.
+   */
+  search_result solve(Board initial, uint64_t max_nodes = unlimited) {
+    search_result result;
+    if (!is_board_solvable(initial))
+      return result;
+
+    workers_.clear();
+    for (unsigned i = 0; i < workers_count_; i++)
+      workers_.push_back(std::make_unique<worker>(closed_max_bytes_ / workers_count_, workers_count_));
+
+    best_ = no_solution;
+    goal_ = {};
+    stop_ = false;
+    expanded_ = 0;
+    max_nodes_ = max_nodes;
+    outstanding_ = workers_count_;
+
+    unsigned root_owner = owner_of(initial);
+    receive(*workers_[root_owner], {initial, no_node, 0, 0, static_cast<uint16_t>(heuristic_.evaluate(initial)), Nothing});
+
+    std::atomic<unsigned> next_worker = 0;
+    laparca::thread_pool pool(workers_count_, [this, &next_worker]() { run(next_worker++); });
+    pool.join();
+
+    for (auto &w : workers_) {
+      result.expanded += w->expanded;
+      result.generated += w->generated;
+      // The batches left when the search is stopped must be destroyed before the chanel
+      while (w->inbox.try_pop())
+        ;
+    }
+
+    if (best_ != no_solution) {
+      result.solved = true;
+      for (node_ref r = goal_; r.node != no_node;) {
+        const node &n = workers_[r.owner]->nodes[r.node];
+        if (n.direction != Nothing)
+          result.moves.push_back(n.direction);
+        r = {n.parent_owner, n.parent};
+      }
+      std::reverse(result.moves.begin(), result.moves.end());
+    }
+
+    workers_.clear();
+    return result;
+  }
+
+private:
+  static constexpr uint32_t no_solution = std::numeric_limits<uint32_t>::max();
+
+  /**
+   * every worker adds its expanded nodes to the shared counter after this number of expansions.
+   */
+  static constexpr uint64_t report_interval = 1024;
+
+  struct node {
+    Board board;
+    node_handle parent;
+    uint16_t parent_owner;
+    uint16_t moves;
+    Direction direction;
+  };
+
+  struct node_ref {
+    uint16_t owner = 0;
+    node_handle node = no_node;
+  };
+
+  struct message {
+    Board board;
+    node_handle parent;
+    uint16_t parent_owner;
+    uint16_t moves;
+    uint16_t h;
+    Direction direction;
+  };
+
+  using batch = std::vector<message>;
+
+  struct worker {
+    worker(std::size_t closed_max_bytes, unsigned workers) : inbox{chanel_capacity}, closed{closed_max_bytes}, outboxes(workers) {}
+
+    laparca::chanelN<batch> inbox;
+    node_arena<node> nodes;
+    bucket_queue<node_handle> open;
+    board_hash_map<uint16_t> closed;
+    std::vector<batch> outboxes;
+    uint64_t expanded = 0;
+    uint64_t generated = 0;
+  };
+
+  /**
+   * owner_of uses a Fibonacci hash, so the boards of a worker are not all in the same groups
+   * of its closed set, that uses a different hash.
+   */
+  unsigned owner_of(Board b) const { return ((b * 0x9e37'79b9'7f4a'7c15ull) >> 32) * workers_count_ >> 32; }
+
+  void run(unsigned index) {
+    worker &w = *workers_[index];
+    bool idle = false;
+    uint64_t since_report = 0;
+
+    while (!stop_) {
+      while (auto b = w.inbox.try_pop()) {
+        if (idle) {
+          outstanding_++;
+          idle = false;
+        }
+        for (const auto &m : *b)
+          receive(w, m);
+        outstanding_--;
+      }
+
+      // The open list is sorted by f, so nothing in it can improve the incumbent
+      if (!w.open.empty() && w.open.top_f() >= best_)
+        w.open.clear();
+
+      if (w.open.empty()) {
+        if (!flush(w)) {
+          std::this_thread::yield();
+          continue;
+        }
+        if (!idle) {
+          idle = true;
+          outstanding_--;
+        }
+        if (outstanding_ == 0)
+          break;
+        std::this_thread::yield();
+        continue;
+      }
+
+      expand(index, w);
+
+      if (++since_report == report_interval) {
+        since_report = 0;
+        flush(w);
+        if ((expanded_ += report_interval) >= max_nodes_)
+          stop_ = true;
+      }
+    }
+  }
+
+  void expand(unsigned index, worker &w) {
+    node_handle top = w.open.top();
+    uint32_t f = w.open.top_f();
+    w.open.pop();
+
+    const node current = w.nodes[top];
+    // A shorter path to the board was found after this node was queued
+    if (auto moves = w.closed.find(current.board); moves != nullptr && *moves < current.moves)
+      return;
+
+    w.expanded++;
+    if (current.board == solved_board) {
+      std::lock_guard lock{goal_mutex_};
+      if (current.moves < best_) {
+        best_ = current.moves;
+        goal_ = {static_cast<uint16_t>(index), top};
+      }
+      return;
+    }
+
+    const int h = f - current.moves;
+    for (auto d : directions) {
+      if (d == inverse(current.direction))
+        continue;
+
+      auto m = move_tile(current.board, d);
+      if (!m)
+        continue;
+
+      w.generated++;
+      message child{m->board, top, static_cast<uint16_t>(index), static_cast<uint16_t>(current.moves + 1),
+                    static_cast<uint16_t>(heuristic_.update(h, *m)), d};
+      if (static_cast<uint32_t>(child.moves + child.h) >= best_)
+        continue;
+
+      unsigned owner = owner_of(child.board);
+      if (owner == index) {
+        receive(w, child);
+        continue;
+      }
+
+      batch &outbox = w.outboxes[owner];
+      outbox.push_back(child);
+      if (outbox.size() >= batch_size)
+        send(owner, outbox);
+    }
+  }
+
+  void receive(worker &w, const message &m) {
+    if (static_cast<uint32_t>(m.moves + m.h) >= best_)
+      return;
+
+    if (w.closed.insert_or_improve(m.board, m.moves) == board_hash_map<uint16_t>::insert_result::not_improved)
+      return;
+
+    w.open.push(m.moves + m.h, m.moves, w.nodes.push_back({m.board, m.parent, m.parent_owner, m.moves, m.direction}));
+  }
+
+  /**
+   * send tries to put the batch in the chanel of its owner. If the chanel is full, the batch
+   * stays in the outbox and more children are added to it.
+   */
+  bool send(unsigned owner, batch &outbox) {
+    outstanding_++;
+    if (!workers_[owner]->inbox.try_push(std::move(outbox))) {
+      outstanding_--;
+      return false;
+    }
+
+    outbox = batch{};
+    outbox.reserve(batch_size);
+    return true;
+  }
+
+  /**
+   * flush sends every pending batch.
+   *
+   * \return true if all the outboxes are empty.
+   */
+  bool flush(worker &w) {
+    bool all_sent = true;
+    for (unsigned owner = 0; owner < workers_count_; owner++)
+      if (!w.outboxes[owner].empty() && !send(owner, w.outboxes[owner]))
+        all_sent = false;
+    return all_sent;
+  }
+
+  const Heuristic &heuristic_;
+  const std::size_t closed_max_bytes_;
+  const unsigned workers_count_;
+  std::vector<std::unique_ptr<worker>> workers_;
+
+  std::atomic<uint32_t> best_ = no_solution;
+  std::mutex goal_mutex_;
+  node_ref goal_;
+
+  std::atomic<int64_t> outstanding_ = 0;
+  std::atomic<bool> stop_ = false;
+  std::atomic<uint64_t> expanded_ = 0;
+  uint64_t max_nodes_ = unlimited;
+};
@@ -0,0 +1,303 @@
+#pragma once
+
+#include "board.hpp"
+#include "closed_set.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/* A heuristic is any type with the members
+ *
+ *     int evaluate(Board b) const;
+ *     int update(int value, const tile_move &m) const;
+ *
+ * evaluate returns an estimation of the moves needed to solve the board. update returns
+ * the same value for m.board knowing that value is the estimation for the board before
+ * the move, so the solvers carry the value from parent to child instead of evaluating
+ * every new board from scratch.
+ *
+ * The solvers take the heuristic as a template parameter, so the calls are resolved at
+ * compile time. An admissible heuristic (one that never overestimates) makes the
+ * solutions of A* and IDA* optimal. manhattan_heuristic, linear_conflict_heuristic,
+ * walking_distance_heuristic and pattern_database are admissible.
+ */
+
+/**
+ * manhattan_heuristic is the sum, for every tile, of the horizontal and vertical
+ * moves needed to take it to its position in the solved board. It never
+ * overestimates the number of moves, so optimal searches can use it.
+ *
+ * The distances are precomputed for each tile and position, so evaluating a
+ * board is a loop over its 16 nibbles without allocations.
+ */
+struct manhattan_heuristic {
+  /**
+   * distance[tile][position] is the Manhattan distance from position to the place of
+   * tile in the solved board. It is 0 for the hole.
+   */
+  static constexpr std::array<std::array<uint8_t, 16>, 16> distance = [] {
+    std::array<std::array<uint8_t, 16>, 16> table{};
+    for (int tile = 1; tile < 16; tile++) {
+      int goal = 16 - tile;
+      for (int position = 0; position < 16; position++) {
+        int dx = position % 4 - goal % 4;
+        int dy = position / 4 - goal / 4;
+        table[tile][position] = (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+      }
+    }
+    return table;
+  }();
+
+  int evaluate(Board b) const {
+    int sum = 0;
+    for (int position = 0; position < 16; position++, b >>= 4)
+      sum += distance[b & 0xfull][position];
+    return sum;
+  }
+
+  /**
+   * Only the moved tile changes its distance, by one.
+   */
+  int update(int value, const tile_move &m) const { return value - distance[m.tile][m.from] + distance[m.tile][m.to]; }
+};
+
+/**
+ * manhattan_to_heuristic is the Manhattan distance to any board instead of the solved
+ * one. The bidirectional search uses it to estimate the moves from a board back to the
+ * initial one.
+ */
+class manhattan_to_heuristic {
+public:
+  explicit manhattan_to_heuristic(Board target) {
+    for (int target_position = 0; target_position < 16; target_position++, target >>= 4) {
+      int tile = target & 0xfull;
+      if (tile == 0)
+        continue;
+      for (int position = 0; position < 16; position++) {
+        int dx = position % 4 - target_position % 4;
+        int dy = position / 4 - target_position / 4;
+        distance_[tile][position] = (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+      }
+    }
+  }
+
+  int evaluate(Board b) const {
+    int sum = 0;
+    for (int position = 0; position < 16; position++, b >>= 4)
+      sum += distance_[b & 0xfull][position];
+    return sum;
+  }
+
+  int update(int value, const tile_move &m) const { return value - distance_[m.tile][m.from] + distance_[m.tile][m.to]; }
+
+private:
+  std::array<std::array<uint8_t, 16>, 16> distance_{};
+};
+
+/**
+ * line_conflict_penalty returns the moves that the tiles of a line (a row or a column) need
+ * besides their Manhattan distance. goals has, for each tile of the line in the order of the
+ * positions, its place in the line when it is solved, or -1 if it is solved in other line.
+ * The tiles that are not in the longest increasing sequence must leave the line and come
+ * back, that is two moves more each.
+ */
+template <std::size_t N> int line_conflict_penalty(const int (&goals)[N]) {
+  int longest[N];
+  int best = 0;
+  int tiles = 0;
+  for (std::size_t i = 0; i < N; i++) {
+    if (goals[i] < 0)
+      continue;
+    tiles++;
+    longest[i] = 1;
+    for (std::size_t j = 0; j < i; j++)
+      if (goals[j] >= 0 && goals[j] < goals[i])
+        longest[i] = std::max(longest[i], longest[j] + 1);
+    best = std::max(best, longest[i]);
+  }
+  return 2 * (tiles - best);
+}
+
+/**
+ * linear_conflict_heuristic is the Manhattan distance plus the linear conflicts: two tiles
+ * in the row (or column) where both are solved, but in the opposite order, need two more
+ * moves because one of them must leave the line. It is admissible and never smaller than
+ * manhattan_heuristic.
+ *
+ * The penalty of every row and column is read from tables indexed by the 16 bits of the
+ * line, so a board is evaluated with 8 lookups. They are built the first time the heuristic
+ * is created (512 KiB) and shared by all the instances.
+ */
+class linear_conflict_heuristic {
+public:
+  linear_conflict_heuristic() : tables_{&tables()} {}
+
+  int evaluate(Board b) const {
+    int sum = manhattan_heuristic{}.evaluate(b);
+    for (int line = 0; line < 4; line++)
+      sum += tables_->rows[line][row_of(b, line)] + tables_->columns[line][column_of(b, line)];
+    return sum;
+  }
+
+  /**
+   * A vertical move only changes the conflicts of the two rows involved and a horizontal
+   * move, the ones of the two columns.
+   */
+  int update(int value, const tile_move &m) const {
+    Board before = (m.board & ~(0xfull << (4 * m.to))) | (Board{m.tile} << (4 * m.from));
+    value += manhattan_heuristic::distance[m.tile][m.to] - manhattan_heuristic::distance[m.tile][m.from];
+    if (m.from / 4 == m.to / 4) {
+      for (int column : {m.from % 4, m.to % 4})
+        value += tables_->columns[column][column_of(m.board, column)] - tables_->columns[column][column_of(before, column)];
+    } else {
+      for (int row : {m.from / 4, m.to / 4})
+        value += tables_->rows[row][row_of(m.board, row)] - tables_->rows[row][row_of(before, row)];
+    }
+    return value;
+  }
+
+private:
+  struct conflict_tables {
+    std::array<std::array<uint8_t, 65536>, 4> rows;
+    std::array<std::array<uint8_t, 65536>, 4> columns;
+  };
+
+  static uint16_t row_of(Board b, int row) { return b >> (16 * row); }
+
+  static uint16_t column_of(Board b, int column) {
+    b >>= 4 * column;
+    return (b & 0xf) | ((b >> 12) & 0xf0) | ((b >> 24) & 0xf00) | ((b >> 36) & 0xf000);
+  }
+
+  static const conflict_tables &tables() {
+    static const auto tables = [] {
+      auto t = std::make_unique<conflict_tables>();
+      for (int line = 0; line < 4; line++) {
+        for (unsigned value = 0; value < 65536; value++) {
+          int row_goals[4];
+          int column_goals[4];
+          for (int k = 0; k < 4; k++) {
+            int tile = (value >> (4 * k)) & 0xf;
+            int goal = 16 - tile;
+            row_goals[k] = tile != 0 && goal / 4 == line ? goal % 4 : -1;
+            column_goals[k] = tile != 0 && goal % 4 == line ? goal / 4 : -1;
+          }
+          t->rows[line][value] = line_conflict_penalty(row_goals);
+          t->columns[line][value] = line_conflict_penalty(column_goals);
+        }
+      }
+      return t;
+    }();
+    return *tables;
+  }
+
+  const conflict_tables *tables_;
+};
+
+/**
+ * walking_distance_heuristic is the walking distance of Takahashi. For the rows, a board is
+ * abstracted to how many tiles of each goal row are in every row, plus the row of the hole,
+ * and the moves needed to solve that abstraction (only the vertical moves change it) are
+ * computed once with a breadth first search. The same is done for the columns and the
+ * horizontal moves, and the two distances are added. Both problems are the same, so they
+ * share one table of about 25000 states.
+ *
+ * It is admissible and it is usually stronger than the Manhattan distance, because it
+ * takes into account that the tiles of a row get in the way of each other.
+ */
+class walking_distance_heuristic {
+public:
+  walking_distance_heuristic() : table_{&table()} {}
+
+  int evaluate(Board b) const {
+    uint64_t rows = 0;
+    uint64_t columns = 0;
+    for (int position = 0; position < 16; position++, b >>= 4) {
+      int tile = b & 0xf;
+      if (tile == 0) {
+        rows |= uint64_t(position / 4) << hole_shift;
+        columns |= uint64_t(position % 4) << hole_shift;
+        continue;
+      }
+      int goal = 16 - tile;
+      rows += uint64_t{1} << (3 * (4 * (position / 4) + goal / 4));
+      columns += uint64_t{1} << (3 * (4 * (position % 4) + goal % 4));
+    }
+    return *table_->find(rows) + *table_->find(columns);
+  }
+
+  /**
+   * The abstraction of the new board is looked up again: it is already a handful of
+   * operations and two lookups.
+   */
+  int update(int, const tile_move &m) const { return evaluate(m.board); }
+
+private:
+  /**
+   * A state has 3 bits for each line and goal line with the number of tiles (0 to 4) and
+   * the line of the hole over them.
+   */
+  static constexpr int hole_shift = 48;
+
+  static int count(uint64_t state, int line, int goal) { return (state >> (3 * (4 * line + goal))) & 7; }
+
+  static const board_hash_map<uint8_t> &table() {
+    static const auto table = [] {
+      auto distances = std::make_unique<board_hash_map<uint8_t>>();
+      uint64_t goal = 0;
+      for (int line = 0; line < 4; line++)
+        goal += uint64_t(line == 0 ? 3 : 4) << (3 * (4 * line + line));
+
+      std::vector<uint64_t> layer{goal};
+      distances->insert_or_assign(goal, 0);
+      for (uint8_t distance = 1; !layer.empty(); distance++) {
+        std::vector<uint64_t> next;
+        for (uint64_t state : layer) {
+          int hole = state >> hole_shift;
+          for (int line : {hole - 1, hole + 1}) {
+            if (line < 0 || line > 3)
+              continue;
+            for (int g = 0; g < 4; g++) {
+              if (count(state, line, g) == 0)
+                continue;
+              // A tile of the goal line g goes from line to the line of the hole
+              uint64_t moved = (state & ~(uint64_t{3} << hole_shift)) - (uint64_t{1} << (3 * (4 * line + g))) + (uint64_t{1} << (3 * (4 * hole + g))) +
+                               (uint64_t(line) << hole_shift);
+              if (distances->find(moved) == nullptr) {
+                distances->insert_or_assign(moved, distance);
+                next.push_back(moved);
+              }
+            }
+          }
+        }
+        layer = std::move(next);
+      }
+      return distances;
+    }();
+    return *table;
+  }
+
+  const board_hash_map<uint8_t> *table_;
+};
+
+/**
+ * with_heuristic calls f with the heuristic called name: manhattan, linear-conflict or
+ * walking-distance. The solvers are templates on the heuristic, so every one is compiled
+ * for all of them and the command line chooses without recompiling.
+ *
+ * \return the value returned by f or an empty optional if there isn't a heuristic with that name.
+ */
+template <class F> auto with_heuristic(std::string_view name, F &&f) -> std::optional<decltype(f(manhattan_heuristic{}))> {
+  if (name == "manhattan")
+    return f(manhattan_heuristic{});
+  if (name == "linear-conflict")
+    return f(linear_conflict_heuristic{});
+  if (name == "walking-distance")
+    return f(walking_distance_heuristic{});
+  return {};
+}
@@ -0,0 +1,136 @@
+#include "board.hpp"
+#include "heuristic.hpp"
+#include "ida.hpp"
+#include "parallel_ida.hpp"
+#include "pattern_database.hpp"
+#include "search_result.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * solve runs the IDA* and prints the solution.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> int solve(Board initial_board, uint64_t max_nodes, unsigned threads, const Heuristic &heuristic) {
+  int iterations = 0;
+
+  auto start_time = std::chrono::system_clock::now();
+  auto iteration_time = start_time;
+  auto on_iteration = [&](int bound, uint64_t nodes) {
+    auto t = std::chrono::system_clock::now();
+    std::chrono::duration<double> diff = t - iteration_time;
+    std::cout << "bound = " << bound << "; nodes = " << nodes << "; duration = " << diff.count() << "; " << std::setprecision(10) << nodes / diff.count()
+              << " nodes / s" << std::endl;
+    iteration_time = t;
+    iterations++;
+  };
+
+  search_result result;
+  if (threads > 1) {
+    parallel_ida_star<Heuristic> ida{heuristic, threads};
+    result = ida.solve(initial_board, max_nodes, [&](int bound, uint64_t nodes, const std::vector<worker_stats> &workers) {
+      on_iteration(bound, nodes);
+      for (std::size_t i = 0; i < workers.size(); i++)
+        std::cout << "    worker " << i << ": nodes = " << workers[i].expanded << "; stolen = " << workers[i].stolen << "; " << std::setprecision(10)
+                  << workers[i].nodes_per_second() << " nodes / s" << std::endl;
+    });
+  } else {
+    ida_star<Heuristic> ida{heuristic};
+    result = ida.solve(initial_board, max_nodes, on_iteration);
+  }
+  std::chrono::duration<double> total = std::chrono::system_clock::now() - start_time;
+
+  std::cout << "Iterations: " << iterations << std::endl;
+  std::cout << "Expanded  : " << result.expanded << std::endl;
+  std::cout << "Generated : " << result.generated << std::endl;
+  std::cout << "Duration  : " << total.count() << std::endl;
+
+  if (!result.solved) {
+    std::cout << "There isn't solution" << std::endl;
+  } else {
+    std::cout << "Moves     : " << result.moves.size() << std::endl;
+    std::cout << "Solution: " << result.moves << std::endl;
+  }
+
+  return 0;
+}
+
+int main(int argc, const char **argv) {
+  Board initial_board = default_board;
+  uint64_t max_nodes = ida_star<manhattan_heuristic>::unlimited;
+  unsigned threads = 1;
+  std::optional<pattern_database> pdb;
+  std::string_view heuristic_name = "manhattan";
+
+  using namespace std::literals;
+
+  for (int arg = 1; arg < argc; arg++) {
+    if ("--board"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        auto board = parse_board(argv[++arg]);
+        if (!board) {
+          std::cerr << "Invalid board " << argv[arg] << std::endl;
+          return 1;
+        }
+        initial_board = *board;
+      } else {
+        std::cerr << "No board found" << std::endl;
+        return 1;
+      }
+    } else if ("--heuristic"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        heuristic_name = argv[++arg];
+      } else {
+        std::cerr << "No heuristic found" << std::endl;
+        return 1;
+      }
+    } else if ("--pdb"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        pdb = pattern_database::open(argv[++arg]);
+        if (!pdb) {
+          std::cerr << "Cannot load the pattern database " << argv[arg] << ": " << std::strerror(errno) << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No pattern database found" << std::endl;
+        return 1;
+      }
+    } else if ("--threads"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        threads = std::stoul(argv[++arg]);
+        if (threads == 0) {
+          std::cerr << "Invalid number of threads " << argv[arg] << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No number of threads found" << std::endl;
+        return 1;
+      }
+    } else
+      max_nodes = std::stoull(argv[arg]);
+  }
+
+  if (!is_board_solvable(initial_board)) {
+    std::cerr << "The board cannot be solved." << std::endl;
+    return 2;
+  }
+
+  if (pdb)
+    return solve(initial_board, max_nodes, threads, *pdb);
+
+  if (auto status = with_heuristic(heuristic_name, [&](const auto &heuristic) { return solve(initial_board, max_nodes, threads, heuristic); }))
+    return *status;
+
+  std::cerr << "Unknown heuristic " << heuristic_name << std::endl;
+  return 1;
+}
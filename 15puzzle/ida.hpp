@@ -0,0 +1,161 @@
+#pragma once
+
+#include "board.hpp"
+#include "search_result.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+/**
+ * ida_max_depth is the longest solution IDA* can find. Every 15 puzzle board is solved
+ * in 80 moves or less.
+ */
+constexpr int ida_max_depth = 128;
+
+/**
+ * ida_star runs an iterative deepening A*: depth first searches that cut the branches with
+ * f = g + h over a bound. The first bound is the heuristic of the initial board and each new
+ * iteration uses the smallest f that was over the previous bound, so the first solution found
+ * is optimal when the heuristic is admissible.
+ *
+ * The depth first search uses a fixed size stack of frames instead of recursion and never goes
+ * back through the move that undoes the previous one. Nothing is allocated per node, the memory
+ * used is linear in the depth of the solution.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> class ida_star {
+public:
+  static constexpr uint64_t unlimited = std::numeric_limits<uint64_t>::max();
+
+  /**
+   * stop_check_interval is the number of expanded nodes between calls to should_stop.
+   */
+  static constexpr uint64_t stop_check_interval = 1024;
+
+  explicit ida_star(const Heuristic &heuristic) : heuristic_{heuristic} {}
+
+  /**
+   * solve searches the moves that solve the board.
+   *
+   * \param max_nodes the search stops after expanding this number of nodes.
+   * \param on_iteration called at the end of every iteration with the bound used and the number of
+   *                     nodes expanded in it.
+   * \param should_stop called every stop_check_interval expanded nodes. If it returns true, the
+   *                    search ends without a solution.
+   */
+  template <class Observer, class Stop> search_result solve(Board initial, uint64_t max_nodes, Observer &&on_iteration, Stop &&should_stop) {
+    search_result result;
+    if (!is_board_solvable(initial))
+      return result;
+
+    int bound = heuristic_.evaluate(initial);
+    while (true) {
+      uint64_t expanded_before = result.expanded;
+      int next_bound = std::numeric_limits<int>::max();
+      bool finished = search(initial, bound, next_bound, max_nodes, result, should_stop);
+
+      on_iteration(bound, result.expanded - expanded_before);
+
+      if (finished || next_bound == std::numeric_limits<int>::max() || next_bound > ida_max_depth)
+        return result;
+
+      bound = next_bound;
+    }
+  }
+
+  template <class Observer> search_result solve(Board initial, uint64_t max_nodes, Observer &&on_iteration) {
+    return solve(initial, max_nodes, on_iteration, [] { return false; });
+  }
+
+  search_result solve(Board initial, uint64_t max_nodes = unlimited) {
+    return solve(initial, max_nodes, [](int, uint64_t) {});
+  }
+
+  /**
+   * search_from runs one iteration over the subtree of a board that was reached with g moves,
+   * the last one being from. It is used to split the iterations between threads.
+   *
+   * The moves from the board to the solution are appended to result.moves.
+   *
+   * \param should_stop called every stop_check_interval expanded nodes. If it returns true, the
+   *                    search ends.
+   * \return true when the search has ended: the board is solved, the nodes limit was reached or
+   *         should_stop returned true.
+   */
+  template <class Stop>
+  bool search_from(Board board, int g, int h, Direction from, int bound, int &next_bound, uint64_t max_nodes, search_result &result, Stop &&should_stop) {
+    int depth = 0;
+    stack_[0] = {board, h, from, 0};
+
+    while (depth >= 0) {
+      frame &current = stack_[depth];
+      if (current.next == 4) {
+        depth--;
+        continue;
+      }
+
+      Direction d = static_cast<Direction>(current.next++);
+      if (d == inverse(current.from))
+        continue;
+
+      auto child = move_tile(current.board, d);
+      if (!child)
+        continue;
+
+      result.generated++;
+      int h = heuristic_.update(current.h, *child);
+      int f = g + depth + 1 + h;
+      if (f > bound) {
+        next_bound = std::min(next_bound, f);
+        continue;
+      }
+
+      if (child->board == solved_board) {
+        result.solved = true;
+        for (int i = 1; i <= depth; i++)
+          result.moves.push_back(stack_[i].from);
+        result.moves.push_back(d);
+        return true;
+      }
+
+      if (g + depth + 1 >= ida_max_depth)
+        continue;
+
+      stack_[++depth] = {child->board, h, d, 0};
+      if (++result.expanded >= max_nodes)
+        return true;
+      if (result.expanded % stop_check_interval == 0 && should_stop())
+        return true;
+    }
+
+    return false;
+  }
+
+private:
+  struct frame {
+    Board board;
+    int h;
+    Direction from;
+    uint8_t next;
+  };
+
+  /**
+   * runs one iteration. It returns true when the search has ended: the board is solved, the
+   * nodes limit was reached or should_stop returned true.
+   */
+  template <class Stop> bool search(Board initial, int bound, int &next_bound, uint64_t max_nodes, search_result &result, Stop &&should_stop) {
+    if (initial == solved_board) {
+      result.solved = true;
+      return true;
+    }
+
+    result.moves.clear();
+    return search_from(initial, 0, heuristic_.evaluate(initial), Nothing, bound, next_bound, max_nodes, result, should_stop);
+  }
+
+  const Heuristic &heuristic_;
+  std::array<frame, ida_max_depth> stack_;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "board.hpp"
+#include "radix_sort.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * layered_bfs is a breadth-first frontier search from a board: it builds the boards at every
+ * distance, one layer at a time, in flat vectors of boards. There are no hash lookups:
+ *
+ * - every board of the layer writes its successors in the next layer, in parallel, to places
+ *   known in advance from the number of legal moves of the position of its hole;
+ * - the next layer is sorted with parallel_radix_sort and its duplicates removed;
+ * - the boards that are in the current or in the previous layer are removed merging the
+ *   sorted layers. In an undirected graph the successors of a layer are only in those layers
+ *   or new.
+ *
+ * Only three layers are in memory, so it is how the number of boards at each distance is
+ * computed and how heuristics and pattern databases are checked against the real distances.
+ *
+ * \param max_depth the last layer built.
+ * \param on_layer called with the distance and the sorted boards of every layer, beginning
+ *                 with the layer 0, that only has the start board.
+ */
+template <class Observer> void layered_bfs(Board start, int max_depth, unsigned threads, Observer &&on_layer) {
+  std::vector<uint64_t> previous;
+  std::vector<uint64_t> current{start};
+  std::vector<std::size_t> offsets;
+
+  on_layer(0, static_cast<const std::vector<uint64_t> &>(current));
+  for (int depth = 1; depth <= max_depth && !current.empty(); depth++) {
+    // The successors of every chunk go after the ones of the chunks before
+    offsets.assign(std::max(threads, 1u) + 1, 0);
+    parallel_chunks(threads, current.size(), [&](unsigned t, std::size_t begin, std::size_t end) {
+      std::size_t count = 0;
+      for (std::size_t i = begin; i < end; i++)
+        count += __builtin_popcount(playgroundcpp::board::legal_moves[get_hole_position(current[i])]);
+      offsets[t + 1] = count;
+    });
+    for (std::size_t t = 1; t < offsets.size(); t++)
+      offsets[t] += offsets[t - 1];
+
+    std::vector<uint64_t> next(offsets.back());
+    parallel_chunks(threads, current.size(), [&](unsigned t, std::size_t begin, std::size_t end) {
+      std::size_t place = offsets[t];
+      for (std::size_t i = begin; i < end; i++) {
+        const auto children = playgroundcpp::board::successors_of(current[i]);
+        for (int c = 0; c < children.count; c++)
+          next[place++] = children.moves[c].board;
+      }
+    });
+
+    parallel_radix_sort(next, threads);
+    next.erase(std::unique(next.begin(), next.end()), next.end());
+
+    // Both layers are sorted, so they are walked once along the new one
+    std::size_t kept = 0;
+    auto in_previous = previous.begin();
+    auto in_current = current.begin();
+    for (Board b : next) {
+      while (in_previous != previous.end() && *in_previous < b)
+        ++in_previous;
+      while (in_current != current.end() && *in_current < b)
+        ++in_current;
+      if ((in_previous != previous.end() && *in_previous == b) || (in_current != current.end() && *in_current == b))
+        continue;
+      next[kept++] = b;
+    }
+    next.resize(kept);
+
+    previous = std::move(current);
+    current = std::move(next);
+    on_layer(depth, static_cast<const std::vector<uint64_t> &>(current));
+  }
+}
@@ -0,0 +1,146 @@
+#include "board.hpp"
+#include "heuristic.hpp"
+#include "layered_bfs.hpp"
+#include "pattern_database.hpp"
+#include "radix_sort.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * heuristic_check is what a heuristic gives for the boards of a layer.
+ */
+struct heuristic_check {
+  uint64_t sum = 0;
+  int max = 0;
+  uint64_t overestimated = 0;
+};
+
+/**
+ * layers builds the layers from the solved board and prints the number of boards at each
+ * distance. When there is a heuristic, it is evaluated for every board: the distance of a
+ * layer is the real number of moves to solve its boards, so a heuristic that gives more is
+ * not admissible.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> int layers(int max_depth, unsigned threads, const Heuristic *heuristic) {
+  uint64_t total = 0;
+  uint64_t overestimated = 0;
+
+  auto start_time = std::chrono::system_clock::now();
+  auto layer_time = start_time;
+  layered_bfs(solved_board, max_depth, threads, [&](int depth, const std::vector<uint64_t> &boards) {
+    auto t = std::chrono::system_clock::now();
+    std::chrono::duration<double> diff = t - layer_time;
+    total += boards.size();
+    std::cout << "depth = " << depth << "; boards = " << boards.size() << "; duration = " << diff.count();
+
+    if (heuristic != nullptr) {
+      std::vector<heuristic_check> checks(std::max(threads, 1u));
+      parallel_chunks(threads, boards.size(), [&](unsigned i, std::size_t begin, std::size_t end) {
+        for (std::size_t b = begin; b < end; b++) {
+          int h = heuristic->evaluate(boards[b]);
+          checks[i].sum += h;
+          checks[i].max = std::max(checks[i].max, h);
+          checks[i].overestimated += h > depth;
+        }
+      });
+
+      heuristic_check layer;
+      for (const auto &c : checks) {
+        layer.sum += c.sum;
+        layer.max = std::max(layer.max, c.max);
+        layer.overestimated += c.overestimated;
+      }
+      overestimated += layer.overestimated;
+      std::cout << "; mean h = " << std::setprecision(4) << static_cast<double>(layer.sum) / boards.size() << "; max h = " << layer.max
+                << "; overestimated = " << layer.overestimated;
+    }
+
+    std::cout << std::endl;
+    layer_time = std::chrono::system_clock::now();
+  });
+  std::chrono::duration<double> diff = std::chrono::system_clock::now() - start_time;
+
+  std::cout << "Boards    : " << total << std::endl;
+  std::cout << "Duration  : " << diff.count() << "; " << std::setprecision(10) << total / diff.count() << " boards / s" << std::endl;
+  if (heuristic != nullptr) {
+    std::cout << "Overestimated: " << overestimated << std::endl;
+    return overestimated == 0 ? 0 : 3;
+  }
+
+  return 0;
+}
+
+int main(int argc, const char **argv) {
+  int max_depth = 20;
+  unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+  std::optional<pattern_database> pdb;
+  std::optional<std::string_view> heuristic_name;
+
+  using namespace std::literals;
+
+  for (int arg = 1; arg < argc; arg++) {
+    if ("--depth"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        max_depth = std::stoi(argv[++arg]);
+      } else {
+        std::cerr << "No depth found" << std::endl;
+        return 1;
+      }
+    } else if ("--threads"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        threads = std::stoul(argv[++arg]);
+        if (threads == 0) {
+          std::cerr << "Invalid number of threads " << argv[arg] << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No number of threads found" << std::endl;
+        return 1;
+      }
+    } else if ("--heuristic"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        heuristic_name = argv[++arg];
+      } else {
+        std::cerr << "No heuristic found" << std::endl;
+        return 1;
+      }
+    } else if ("--pdb"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        pdb = pattern_database::open(argv[++arg]);
+        if (!pdb) {
+          std::cerr << "Cannot load the pattern database " << argv[arg] << ": " << std::strerror(errno) << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No pattern database found" << std::endl;
+        return 1;
+      }
+    } else {
+      std::cerr << "Unknown option " << argv[arg] << std::endl;
+      return 1;
+    }
+  }
+
+  if (pdb)
+    return layers(max_depth, threads, &*pdb);
+
+  if (!heuristic_name)
+    return layers<manhattan_heuristic>(max_depth, threads, nullptr);
+
+  if (auto status = with_heuristic(*heuristic_name, [&](const auto &heuristic) { return layers(max_depth, threads, &heuristic); }))
+    return *status;
+
+  std::cerr << "Unknown heuristic " << *heuristic_name << std::endl;
+  return 1;
+}
@@ -0,0 +1,252 @@
+#include "board.hpp"
+#include "solver_protocol.hpp"
+#include "unix_socket.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * load_options are the parameters of the load generator read from the command line.
+ */
+struct load_options {
+  std::string socket_path = "/tmp/15puzzle.sock";
+  unsigned connections = 4;
+  uint64_t requests = 1000;
+  /**
+   * walk_length is the number of random moves from the solved board of the generated boards,
+   * when they are not read from a file.
+   */
+  int walk_length = 40;
+  uint64_t max_nodes = 0;
+  uint64_t max_milliseconds = 0;
+};
+
+/**
+ * random_walk returns the board reached with length random moves from the solved board, never
+ * undoing the previous move.
+ */
+Board random_walk(std::mt19937_64 &random, int length) {
+  Board b = solved_board;
+  Direction last = Nothing;
+  for (int step = 0; step < length;) {
+    Direction d = directions[random() % 4];
+    if (d == inverse(last))
+      continue;
+    auto next = move(b, d);
+    if (!next)
+      continue;
+    b = *next;
+    last = d;
+    step++;
+  }
+  return b;
+}
+
+/**
+ * percentile returns the value below which there are the fraction p of the sorted values.
+ */
+double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  std::size_t i = std::min(sorted.size() - 1, static_cast<std::size_t>(p * sorted.size()));
+  return sorted[i];
+}
+
+/**
+ * load sends the requests to the daemon from several connections at the same time. Every
+ * connection waits for the response before sending the next request, so there are as many
+ * requests in flight as connections, and the latency of each one is measured from the send to
+ * the response.
+ */
+int load(const load_options &options, const std::vector<Board> &boards) {
+  std::mutex results_mutex;
+  std::vector<double> latencies;
+  std::atomic<uint64_t> next_request = 0;
+  std::atomic<uint64_t> solved = 0;
+  std::atomic<uint64_t> unsolved = 0;
+  std::atomic<uint64_t> errors = 0;
+  std::atomic<uint64_t> expanded = 0;
+
+  auto start_time = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (unsigned c = 0; c < options.connections; c++) {
+    threads.emplace_back([&] {
+      int fd = connect_unix(options.socket_path);
+      if (fd < 0) {
+        std::lock_guard lock{results_mutex};
+        std::cerr << "Cannot connect to " << options.socket_path << ": " << std::strerror(errno) << std::endl;
+        errors++;
+        return;
+      }
+
+      line_reader input;
+      std::string line;
+      std::vector<double> measured;
+      for (uint64_t i; (i = next_request++) < options.requests;) {
+        solve_request request{boards[i % boards.size()], options.max_nodes, options.max_milliseconds};
+        auto send_time = std::chrono::steady_clock::now();
+        if (!send_all(fd, format_request(request))) {
+          errors++;
+          break;
+        }
+
+        bool answered = false;
+        while (!(answered = input.next(line)) && input.read(fd)) {
+        }
+        if (!answered) {
+          errors++;
+          break;
+        }
+        std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - send_time;
+        measured.push_back(latency.count());
+
+        auto response = parse_response(line);
+        if (!response || response->board != request.board) {
+          errors++;
+          std::lock_guard lock{results_mutex};
+          std::cerr << "Unexpected response " << line << std::endl;
+        } else if (response->status == solve_status::solved) {
+          solved++;
+          expanded += response->expanded;
+        } else {
+          unsolved++;
+          expanded += response->expanded;
+        }
+      }
+      ::close(fd);
+
+      std::lock_guard lock{results_mutex};
+      latencies.insert(latencies.end(), measured.begin(), measured.end());
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+  std::chrono::duration<double> total = std::chrono::steady_clock::now() - start_time;
+
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << "Connections: " << options.connections << std::endl;
+  std::cout << "Requests   : " << latencies.size() << std::endl;
+  std::cout << "Solved     : " << solved << std::endl;
+  std::cout << "Unsolved   : " << unsolved << std::endl;
+  std::cout << "Errors     : " << errors << std::endl;
+  std::cout << "Expanded   : " << expanded << std::endl;
+  std::cout << "Duration   : " << total.count() << "; " << std::setprecision(10) << latencies.size() / total.count() << " requests / s" << std::endl;
+  std::cout << "Latency    : p50 = " << percentile(latencies, 0.5) << " ms; p99 = " << percentile(latencies, 0.99)
+            << " ms; max = " << (latencies.empty() ? 0 : latencies.back()) << " ms" << std::endl;
+
+  return errors == 0 ? 0 : 1;
+}
+
+int main(int argc, const char **argv) {
+  load_options options;
+  std::vector<Board> boards;
+  uint64_t seed = 1;
+
+  using namespace std::literals;
+
+  for (int arg = 1; arg < argc; arg++) {
+    if ("--socket"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.socket_path = argv[++arg];
+      } else {
+        std::cerr << "No socket path found" << std::endl;
+        return 1;
+      }
+    } else if ("--connections"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.connections = std::stoul(argv[++arg]);
+        if (options.connections == 0) {
+          std::cerr << "Invalid number of connections " << argv[arg] << std::endl;
+          return 1;
+        }
+      } else {
+        std::cerr << "No number of connections found" << std::endl;
+        return 1;
+      }
+    } else if ("--requests"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.requests = std::stoull(argv[++arg]);
+      } else {
+        std::cerr << "No number of requests found" << std::endl;
+        return 1;
+      }
+    } else if ("--input"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        std::ifstream file{argv[++arg]};
+        if (!file) {
+          std::cerr << "Cannot open " << argv[arg] << ": " << std::strerror(errno) << std::endl;
+          return 1;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+          if (line.empty() || line[0] == '#')
+            continue;
+          auto board = parse_board(line);
+          if (!board)
+            board = parse_tiles(line);
+          if (!board) {
+            std::cerr << "Invalid board " << line << std::endl;
+            return 1;
+          }
+          boards.push_back(*board);
+        }
+      } else {
+        std::cerr << "No input file found" << std::endl;
+        return 1;
+      }
+    } else if ("--walk-length"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.walk_length = std::stoi(argv[++arg]);
+      } else {
+        std::cerr << "No walk length found" << std::endl;
+        return 1;
+      }
+    } else if ("--seed"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        seed = std::stoull(argv[++arg]);
+      } else {
+        std::cerr << "No seed found" << std::endl;
+        return 1;
+      }
+    } else if ("--max-nodes"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.max_nodes = std::stoull(argv[++arg]);
+      } else {
+        std::cerr << "No number of nodes found" << std::endl;
+        return 1;
+      }
+    } else if ("--max-ms"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.max_milliseconds = std::stoull(argv[++arg]);
+      } else {
+        std::cerr << "No time limit found" << std::endl;
+        return 1;
+      }
+    } else {
+      std::cerr << "Unknown option " << argv[arg] << std::endl;
+      return 1;
+    }
+  }
+
+  // The generated boards are the same for the same seed, so the runs can be compared
+  if (boards.empty()) {
+    std::mt19937_64 random{seed};
+    for (uint64_t i = 0; i < std::min<uint64_t>(options.requests, 1024); i++)
+      boards.push_back(random_walk(random, options.walk_length));
+  }
+
+  return load(options, boards);
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "board.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * move_pruning is a finite state machine that prunes the sequences of moves that lead to a
+ * board that another sequence, not longer, also reaches (Taylor and Korf, "Pruning duplicate
+ * nodes in depth-first search"): the moves that undo the last one, the half turns around a 2x2
+ * block, that are the same as the half turn the other way, and the other duplicates of up to
+ * max_length moves.
+ *
+ * The duplicates are found once, moving the hole in a board with no borders and comparing the
+ * positions of the tiles. Of every pair, the sequence that is longer or, with the same length,
+ * bigger in the order of the directions is pruned. It is only pruned if the other one moves
+ * the hole over the same positions or less of them, so the other one can be done in any board
+ * where the pruned one can, and every board is still reached by its shortest path.
+ *
+ * The pruned sequences are compiled in a table of transitions (an Aho-Corasick automaton), so
+ * a search node only keeps a state of one byte and the pruned moves of a node are a mask:
+ *
+ *     uint8_t moves = legal_moves & pruning.allowed(node.state);
+ *     child.state = pruning.next(node.state, d);
+ */
+class move_pruning {
+public:
+  using state = uint8_t;
+
+  /**
+   * max_length is the length of the longest duplicate sequence searched. The states of the
+   * automaton of the longer ones do not fit in a byte.
+   */
+  static constexpr int max_length = 8;
+
+  /**
+   * start is the state of the initial board, before any move.
+   */
+  static constexpr state start = 0;
+
+  move_pruning() : tables_{&tables()} {}
+
+  /**
+   * returns the directions that can follow the moves that led to the state: bit d is set if
+   * the direction d does not complete a pruned sequence.
+   */
+  uint8_t allowed(state s) const { return tables_->allowed[s]; }
+
+  /**
+   * returns the state after the direction d. d must be allowed in the state s.
+   */
+  state next(state s, Direction d) const { return tables_->next[s][d]; }
+
+  /**
+   * returns the number of states of the automaton.
+   */
+  std::size_t states() const { return tables_->allowed.size(); }
+
+  /**
+   * returns the pruned sequences. No one has another one inside.
+   */
+  const std::vector<std::vector<Direction>> &pruned() const { return tables_->pruned; }
+
+private:
+  struct transition_tables {
+    std::vector<std::array<state, 4>> next;
+    std::vector<uint8_t> allowed;
+    std::vector<std::vector<Direction>> pruned;
+  };
+
+  /**
+   * cell is a position of the board with no borders, x and y packed in a number.
+   */
+  using cell = int;
+
+  static constexpr cell cell_of(int x, int y) { return (x + 64) * 128 + (y + 64); }
+
+  static constexpr cell step(cell c, Direction d) {
+    constexpr int dx[4] = {0, 1, 0, -1};
+    constexpr int dy[4] = {1, 0, -1, 0};
+    return c + dx[d] * 128 + dy[d];
+  }
+
+  /**
+   * effect is what a sequence of moves does: the final position of the hole and the tiles
+   * that are not in their initial positions, with the position each one came from.
+   */
+  using effect = std::pair<cell, std::vector<std::pair<cell, cell>>>;
+
+  /**
+   * applies the moves and returns their effect and the sorted positions visited by the hole.
+   */
+  static std::pair<effect, std::vector<cell>> apply(const std::vector<Direction> &moves) {
+    cell hole = cell_of(0, 0);
+    std::map<cell, cell> origin;
+    std::vector<cell> visited{hole};
+    for (Direction d : moves) {
+      cell next = step(hole, d);
+      auto it = origin.find(next);
+      origin[hole] = it == origin.end() ? next : it->second;
+      origin.erase(next);
+      hole = next;
+      visited.push_back(hole);
+    }
+
+    effect e{hole, {}};
+    for (auto [position, from] : origin)
+      if (position != from)
+        e.second.emplace_back(position, from);
+
+    std::sort(visited.begin(), visited.end());
+    visited.erase(std::unique(visited.begin(), visited.end()), visited.end());
+    return {e, visited};
+  }
+
+  /**
+   * finds the duplicate sequences, shortest first and in the order of the directions, so the
+   * first sequence with an effect is the one that is kept.
+   */
+  static std::vector<std::vector<Direction>> find_pruned() {
+    std::vector<std::vector<Direction>> pruned;
+    for (int d = 0; d < 4; d++)
+      pruned.push_back({static_cast<Direction>(d), inverse(static_cast<Direction>(d))});
+
+    auto contains_pruned = [&](const std::vector<Direction> &moves) {
+      return std::any_of(pruned.begin(), pruned.end(), [&](const auto &p) {
+        return p.size() <= moves.size() && std::equal(p.begin(), p.end(), moves.end() - p.size());
+      });
+    };
+
+    std::map<effect, std::vector<std::vector<cell>>> kept;
+    kept[apply({}).first].push_back(apply({}).second);
+    std::vector<std::vector<Direction>> level{{}};
+    for (int length = 1; length <= max_length; length++) {
+      std::vector<std::vector<Direction>> next_level;
+      for (const auto &moves : level) {
+        for (int d = 0; d < 4; d++) {
+          auto longer = moves;
+          longer.push_back(static_cast<Direction>(d));
+          // The sequences before are not pruned, so only the end of this one is checked
+          if (contains_pruned(longer))
+            continue;
+
+          auto [e, visited] = apply(longer);
+          auto &same = kept[e];
+          if (std::any_of(same.begin(), same.end(), [&](const auto &v) { return std::includes(visited.begin(), visited.end(), v.begin(), v.end()); })) {
+            pruned.push_back(longer);
+            continue;
+          }
+          same.push_back(visited);
+          next_level.push_back(longer);
+        }
+      }
+      level = std::move(next_level);
+    }
+    return pruned;
+  }
+
+  static const transition_tables &tables() {
+    static const auto tables = [] {
+      auto t = std::make_unique<transition_tables>();
+      t->pruned = find_pruned();
+
+      // The trie of the pruned sequences, with the node 0 as the root
+      std::vector<std::array<int, 4>> children(1, {-1, -1, -1, -1});
+      std::vector<bool> pruned_end(1, false);
+      for (const auto &moves : t->pruned) {
+        int node = 0;
+        for (Direction d : moves) {
+          if (children[node][d] < 0) {
+            children[node][d] = children.size();
+            children.push_back({-1, -1, -1, -1});
+            pruned_end.push_back(false);
+          }
+          node = children[node][d];
+        }
+        pruned_end[node] = true;
+      }
+
+      // The failure links complete the transitions, in breadth-first order so the ones of the
+      // shorter suffixes are ready
+      std::vector<int> failure(children.size(), 0);
+      std::vector<std::array<int, 4>> next(children.size());
+      std::vector<int> queue{0};
+      for (std::size_t i = 0; i < queue.size(); i++) {
+        int node = queue[i];
+        pruned_end[node] = pruned_end[node] || pruned_end[failure[node]];
+        for (int d = 0; d < 4; d++) {
+          if (children[node][d] >= 0) {
+            int child = children[node][d];
+            failure[child] = node == 0 ? 0 : next[failure[node]][d];
+            next[node][d] = child;
+            queue.push_back(child);
+          } else {
+            next[node][d] = node == 0 ? 0 : next[failure[node]][d];
+          }
+        }
+      }
+
+      // The nodes that end a pruned sequence are never entered, so they are not states
+      std::vector<int> number(children.size(), -1);
+      for (std::size_t node = 0; node < children.size(); node++)
+        if (!pruned_end[node]) {
+          number[node] = t->allowed.size();
+          t->allowed.push_back(0);
+        }
+      for (std::size_t node = 0; node < children.size(); node++) {
+        if (pruned_end[node])
+          continue;
+        std::array<state, 4> transitions{};
+        uint8_t allowed = 0;
+        for (int d = 0; d < 4; d++) {
+          if (pruned_end[next[node][d]])
+            continue;
+          allowed |= 1 << d;
+          transitions[d] = number[next[node][d]];
+        }
+        t->allowed[number[node]] = allowed;
+        t->next.push_back(transitions);
+      }
+      return t;
+    }();
+    return *tables;
+  }
+
+  const transition_tables *tables_;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * node_handle identifies a node stored in a node_arena. It is four bytes instead of
+ * the eight of a pointer, so open lists and parent links stay small.
+ */
+using node_handle = uint32_t;
+
+/**
+ * no_node is the handle used as parent of the root node.
+ */
+constexpr node_handle no_node = ~node_handle{0};
+
+/**
+ * node_arena stores search nodes once, in fixed size chunks. A node is never moved
+ * after it is created, so growing the arena only allocates a new chunk and never
+ * copies the nodes already stored. References to nodes are stable for the lifetime
+ * of the arena.
+ *
+ * \tparam T type of the stored nodes.
+ * \tparam ChunkBits log2 of the number of nodes in each chunk.
+ */
+template <typename T, unsigned ChunkBits = 16> class node_arena {
+public:
+  using value_type = T;
+
+  static constexpr std::size_t chunk_size = std::size_t{1} << ChunkBits;
+  static constexpr std::size_t chunk_mask = chunk_size - 1;
+
+  node_arena() = default;
+  node_arena(const node_arena &) = delete;
+  node_arena(node_arena &&) = default;
+
+  node_arena &operator=(const node_arena &) = delete;
+  node_arena &operator=(node_arena &&) = default;
+
+  /**
+   * push_back stores a copy of the node at the end of the arena.
+   *
+   * \return the handle of the new node.
+   */
+  node_handle push_back(const T &node) {
+    if ((size_ >> ChunkBits) == chunks_.size())
+      chunks_.emplace_back(new T[chunk_size]);
+
+    node_handle handle = static_cast<node_handle>(size_++);
+    (*this)[handle] = node;
+    return handle;
+  }
+
+  T &operator[](node_handle h) { return chunks_[h >> ChunkBits][h & chunk_mask]; }
+
+  const T &operator[](node_handle h) const { return chunks_[h >> ChunkBits][h & chunk_mask]; }
+
+  /**
+   * returns the number of nodes stored.
+   */
+  std::size_t size() const { return size_; }
+
+  /**
+   * returns the number of bytes reserved by the chunks.
+   */
+  std::size_t bytes() const { return chunks_.size() * chunk_size * sizeof(T); }
+
+  /**
+   * removes all the nodes and releases the chunks.
+   */
+  void clear() {
+    chunks_.clear();
+    size_ = 0;
+  }
+
+private:
+  std::vector<std::unique_ptr<T[]>> chunks_;
+  std::size_t size_ = 0;
+};
@@ -0,0 +1,168 @@
+#include "board.hpp"
+#include "search_result.hpp"
+#include "sliding_heuristic.hpp"
+#include "sliding_ida.hpp"
+#include "sliding_puzzle.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * puzzle_options are the parameters read from the command line.
+ */
+struct puzzle_options {
+  std::string_view size = "4x4";
+  std::optional<std::string_view> tiles;
+  int walk = 40;
+  uint32_t seed = 1;
+  std::string_view heuristic = "linear-conflict";
+  uint64_t max_nodes = std::numeric_limits<uint64_t>::max();
+};
+
+/**
+ * random_walk makes a board walking randomly from the solved one, never undoing the previous
+ * move. The boards of long walks are not uniformly random, but they are solvable and the
+ * length of the walk bounds the length of the solution.
+ */
+template <class Puzzle> typename Puzzle::board_type random_walk(int length, uint32_t seed) {
+  auto b = Puzzle::goal;
+  Direction last = Nothing;
+  for (int step = 0; step < length;) {
+    seed = seed * 1103515245 + 12345;
+    Direction d = directions[(seed >> 16) % 4];
+    if (d == inverse(last))
+      continue;
+    auto m = Puzzle::move(b, d);
+    if (!m)
+      continue;
+    b = m->board;
+    last = d;
+    step++;
+  }
+  return b;
+}
+
+/**
+ * solve runs the IDA* for a puzzle and prints the solution.
+ *
+ * \tparam Puzzle a sliding_puzzle.
+ * \tparam Heuristic a heuristic of the puzzle, as described in sliding_heuristic.hpp.
+ */
+template <class Puzzle, class Heuristic> int solve(const puzzle_options &options) {
+  typename Puzzle::board_type initial;
+  if (options.tiles) {
+    auto board = Puzzle::parse(*options.tiles);
+    if (!board) {
+      std::cerr << "Invalid board " << *options.tiles << std::endl;
+      return 1;
+    }
+    initial = *board;
+  } else {
+    initial = random_walk<Puzzle>(options.walk, options.seed);
+  }
+
+  if (!Puzzle::is_solvable(initial)) {
+    std::cerr << "The board cannot be solved." << std::endl;
+    return 2;
+  }
+
+  std::cout << "Board     : " << Puzzle::to_string(initial) << std::endl;
+
+  Heuristic heuristic;
+  sliding_ida_star<Puzzle, Heuristic> ida{heuristic};
+
+  auto start_time = std::chrono::system_clock::now();
+  auto iteration_time = start_time;
+  auto result = ida.solve(initial, options.max_nodes, [&](int bound, uint64_t nodes) {
+    auto t = std::chrono::system_clock::now();
+    std::chrono::duration<double> diff = t - iteration_time;
+    std::cout << "bound = " << bound << "; nodes = " << nodes << "; duration = " << diff.count() << std::endl;
+    iteration_time = t;
+  });
+  std::chrono::duration<double> total = std::chrono::system_clock::now() - start_time;
+
+  std::cout << "Expanded  : " << result.expanded << std::endl;
+  std::cout << "Generated : " << result.generated << std::endl;
+  std::cout << "Duration  : " << total.count() << "; " << std::setprecision(10) << result.expanded / total.count() << " nodes / s" << std::endl;
+
+  if (!result.solved) {
+    std::cout << "There isn't solution" << std::endl;
+  } else {
+    std::cout << "Moves     : " << result.moves.size() << std::endl;
+    std::cout << "Solution: " << result.moves << std::endl;
+  }
+
+  return 0;
+}
+
+template <class Puzzle> int solve_with_heuristic(const puzzle_options &options) {
+  if (options.heuristic == "manhattan")
+    return solve<Puzzle, sliding_manhattan<Puzzle>>(options);
+  if (options.heuristic == "linear-conflict")
+    return solve<Puzzle, sliding_linear_conflict<Puzzle>>(options);
+
+  std::cerr << "Unknown heuristic " << options.heuristic << std::endl;
+  return 1;
+}
+
+int main(int argc, const char **argv) {
+  puzzle_options options;
+
+  using namespace std::literals;
+
+  for (int arg = 1; arg < argc; arg++) {
+    if ("--size"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.size = argv[++arg];
+      } else {
+        std::cerr << "No size found" << std::endl;
+        return 1;
+      }
+    } else if ("--tiles"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.tiles = argv[++arg];
+      } else {
+        std::cerr << "No tiles found" << std::endl;
+        return 1;
+      }
+    } else if ("--walk"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.walk = std::stoi(argv[++arg]);
+      } else {
+        std::cerr << "No walk length found" << std::endl;
+        return 1;
+      }
+    } else if ("--seed"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.seed = std::stoul(argv[++arg]);
+      } else {
+        std::cerr << "No seed found" << std::endl;
+        return 1;
+      }
+    } else if ("--heuristic"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        options.heuristic = argv[++arg];
+      } else {
+        std::cerr << "No heuristic found" << std::endl;
+        return 1;
+      }
+    } else
+      options.max_nodes = std::stoull(argv[arg]);
+  }
+
+  if (options.size == "3x3")
+    return solve_with_heuristic<eight_puzzle>(options);
+  if (options.size == "4x4")
+    return solve_with_heuristic<fifteen_puzzle>(options);
+  if (options.size == "5x5")
+    return solve_with_heuristic<twenty_four_puzzle>(options);
+
+  std::cerr << "Unknown size " << options.size << "; it can be 3x3, 4x4 or 5x5" << std::endl;
+  return 1;
+}
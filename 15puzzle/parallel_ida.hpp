@@ -0,0 +1,249 @@
+#pragma once
+
+#include "board.hpp"
+#include "ida.hpp"
+#include "search_result.hpp"
+
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/**
+ * worker_stats is what a worker of the parallel IDA* did in one iteration.
+ */
+struct worker_stats {
+  uint64_t expanded = 0;
+  uint64_t stolen = 0;
+  double seconds = 0;
+
+  double nodes_per_second() const { return seconds > 0 ? expanded / seconds : 0; }
+};
+
+/**
+ * parallel_ida_star runs the iterations of IDA* with several threads. Every iteration begins
+ * expanding the first plies of the tree breadth first, until there are tasks_per_worker
+ * subtrees for each worker. The subtrees are dealt to the workers, that search them depth
+ * first with an ida_star each. A worker takes its subtrees from the back of its own deque and,
+ * when it has none left, steals from the front of the deques of the others.
+ *
+ * All the solutions found in an iteration have the same length, so the workers stop as soon as
+ * one of them finds a solution and it is optimal when the heuristic is admissible.
+ *
+ * The memory used is linear in the depth of the solution plus the seeded subtrees.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> class parallel_ida_star {
+public:
+  static constexpr uint64_t unlimited = std::numeric_limits<uint64_t>::max();
+
+  /**
+   * tasks_per_worker is the number of subtrees seeded for every worker.
+   */
+  static constexpr std::size_t tasks_per_worker = 16;
+
+  parallel_ida_star(const Heuristic &heuristic, unsigned workers) : heuristic_{heuristic}, workers_count_{std::max(workers, 1u)} {}
+
+  /**
+   * solve searches the moves that solve the board.
+   *
+   * \param max_nodes the search stops after expanding about this number of nodes.
+   * \param on_iteration called at the end of every iteration with the bound used, the number of
+   *                     nodes expanded in it and the stats of every worker.
+   */
+  template <class Observer> search_result solve(Board initial, uint64_t max_nodes, Observer &&on_iteration) {
+    search_result result;
+    if (!is_board_solvable(initial))
+      return result;
+
+    if (initial == solved_board) {
+      result.solved = true;
+      return result;
+    }
+
+    int bound = heuristic_.evaluate(initial);
+    while (true) {
+      uint64_t expanded_before = result.expanded;
+      int next_bound = std::numeric_limits<int>::max();
+      std::vector<worker_stats> stats(workers_count_);
+      bool finished = iterate(initial, bound, next_bound, max_nodes, result, stats);
+
+      on_iteration(bound, result.expanded - expanded_before, stats);
+
+      if (finished || next_bound == std::numeric_limits<int>::max() || next_bound > ida_max_depth)
+        return result;
+
+      bound = next_bound;
+    }
+  }
+
+  search_result solve(Board initial, uint64_t max_nodes = unlimited) {
+    return solve(initial, max_nodes, [](int, uint64_t, const std::vector<worker_stats> &) {});
+  }
+
+private:
+  struct task {
+    Board board;
+    int h;
+    Direction from;
+    std::vector<Direction> moves;
+  };
+
+  struct task_queue {
+    std::mutex mutex;
+    std::deque<task> tasks;
+  };
+
+  /**
+   * seed expands the tree breadth first until there are enough subtrees. The expanded nodes are
+   * added to the result and, if a solution is found, it is stored in the result.
+   */
+  std::vector<task> seed(Board initial, int bound, int &next_bound, search_result &result) {
+    std::vector<task> frontier{{initial, heuristic_.evaluate(initial), Nothing, {}}};
+
+    for (int g = 0; frontier.size() < workers_count_ * tasks_per_worker && g < ida_max_depth; g++) {
+      std::vector<task> next;
+      for (const auto &t : frontier) {
+        result.expanded++;
+        for (auto d : directions) {
+          if (d == inverse(t.from))
+            continue;
+
+          auto child = move_tile(t.board, d);
+          if (!child)
+            continue;
+
+          result.generated++;
+          int h = heuristic_.update(t.h, *child);
+          if (g + 1 + h > bound) {
+            next_bound = std::min(next_bound, g + 1 + h);
+            continue;
+          }
+
+          next.push_back({child->board, h, d, t.moves});
+          next.back().moves.push_back(d);
+          if (child->board == solved_board) {
+            result.solved = true;
+            result.moves = next.back().moves;
+            return {};
+          }
+        }
+      }
+
+      frontier = std::move(next);
+      if (frontier.empty())
+        break;
+    }
+
+    return frontier;
+  }
+
+  std::optional<task> take(unsigned index, worker_stats &stats) {
+    {
+      task_queue &own = *queues_[index];
+      std::lock_guard lock{own.mutex};
+      if (!own.tasks.empty()) {
+        task t = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        return t;
+      }
+    }
+
+    for (unsigned i = 1; i < workers_count_; i++) {
+      task_queue &victim = *queues_[(index + i) % workers_count_];
+      std::lock_guard lock{victim.mutex};
+      if (!victim.tasks.empty()) {
+        task t = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        stats.stolen++;
+        return t;
+      }
+    }
+
+    return {};
+  }
+
+  /**
+   * runs one iteration. It returns true when the search has ended: the board is solved or the
+   * nodes limit was reached.
+   */
+  bool iterate(Board initial, int bound, int &next_bound, uint64_t max_nodes, search_result &result, std::vector<worker_stats> &stats) {
+    auto tasks = seed(initial, bound, next_bound, result);
+    if (result.solved)
+      return true;
+
+    queues_.clear();
+    for (unsigned i = 0; i < workers_count_; i++)
+      queues_.push_back(std::make_unique<task_queue>());
+    for (std::size_t i = 0; i < tasks.size(); i++)
+      queues_[i % workers_count_]->tasks.push_back(std::move(tasks[i]));
+
+    std::atomic<bool> stop = result.expanded >= max_nodes;
+    std::atomic<uint64_t> expanded = result.expanded;
+    std::atomic<unsigned> next_worker = 0;
+    std::mutex result_mutex;
+
+    laparca::thread_pool pool(workers_count_, [&]() {
+      const unsigned index = next_worker++;
+      auto start = std::chrono::steady_clock::now();
+      ida_star<Heuristic> ida{heuristic_};
+      search_result partial;
+      int partial_next_bound = std::numeric_limits<int>::max();
+      uint64_t reported = 0;
+
+      auto should_stop = [&]() {
+        uint64_t total = expanded += partial.expanded - reported;
+        reported = partial.expanded;
+        if (total >= max_nodes)
+          stop = true;
+        return stop.load();
+      };
+
+      while (!stop) {
+        auto t = take(index, stats[index]);
+        if (!t)
+          break;
+
+        // The nodes limit is checked by should_stop, with the nodes of all the workers
+        partial.moves.clear();
+        int g = static_cast<int>(t->moves.size());
+        ida.search_from(t->board, g, t->h, t->from, bound, partial_next_bound, ida_star<Heuristic>::unlimited, partial, should_stop);
+        should_stop();
+
+        if (partial.solved) {
+          stop = true;
+          std::lock_guard lock{result_mutex};
+          if (!result.solved) {
+            result.solved = true;
+            result.moves = std::move(t->moves);
+            result.moves.insert(result.moves.end(), partial.moves.begin(), partial.moves.end());
+          }
+          break;
+        }
+      }
+
+      std::lock_guard lock{result_mutex};
+      result.expanded += partial.expanded;
+      result.generated += partial.generated;
+      next_bound = std::min(next_bound, partial_next_bound);
+      stats[index].expanded = partial.expanded;
+      stats[index].seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    });
+    pool.join();
+
+    return result.solved || stop;
+  }
+
+  const Heuristic &heuristic_;
+  const unsigned workers_count_;
+  std::vector<std::unique_ptr<task_queue>> queues_;
+};
@@ -0,0 +1,447 @@
+#pragma once
+
+#include "board.hpp"
+#include "closed_set.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+/**
+ * pattern is a group of tiles of an additive pattern database.
+ */
+using pattern = std::vector<int>;
+
+/**
+ * max_pattern_tiles is the size of the biggest pattern. Generating the table of k tiles needs
+ * 16! / (15 - k)! bytes, with ranks that fit in 32 bits only up to 8 tiles.
+ */
+constexpr int max_pattern_tiles = 8;
+
+/**
+ * parse_partition reads a partition of the 15 tiles. It can be a list of sizes, like
+ * "6-6-3" or "7-8", where the tiles are assigned in order (1 to 6, 7 to 12 and 13 to 15),
+ * or a list of groups of tiles, like "1,2,5,6/3,4,7,8/9,10,11,12,13,14,15".
+ *
+ * \return the patterns or an empty optional if the text is not a partition of the 15 tiles
+ *         in patterns of at most max_pattern_tiles tiles.
+ */
+inline std::optional<std::vector<pattern>> parse_partition(std::string_view text) {
+  std::vector<pattern> patterns;
+  unsigned seen = 0;
+
+  if (text.find(',') == std::string_view::npos && text.find('/') == std::string_view::npos) {
+    int next_tile = 1;
+    while (!text.empty()) {
+      auto end = text.find('-');
+      int size = std::atoi(std::string(text.substr(0, end)).c_str());
+      if (size <= 0 || size > max_pattern_tiles || next_tile + size > 16)
+        return {};
+      pattern p;
+      for (int i = 0; i < size; i++)
+        p.push_back(next_tile++);
+      patterns.push_back(std::move(p));
+      text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    }
+    seen = next_tile == 16 ? 0xfffe : 0;
+  } else {
+    while (!text.empty()) {
+      auto end = text.find('/');
+      std::string_view group = text.substr(0, end);
+      pattern p;
+      while (!group.empty()) {
+        auto comma = group.find(',');
+        int tile = std::atoi(std::string(group.substr(0, comma)).c_str());
+        if (tile <= 0 || tile > 15 || (seen & (1u << tile)))
+          return {};
+        seen |= 1u << tile;
+        p.push_back(tile);
+        group.remove_prefix(comma == std::string_view::npos ? group.size() : comma + 1);
+      }
+      if (p.size() > std::size_t{max_pattern_tiles})
+        return {};
+      patterns.push_back(std::move(p));
+      text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    }
+  }
+
+  if (seen != 0xfffe)
+    return {};
+
+  return {patterns};
+}
+
+/**
+ * pattern_database is a disjoint additive pattern database heuristic.
+ *
+ * The tiles are split in groups (patterns). For each pattern, a table stores the minimum
+ * number of moves of the tiles of the pattern needed to take them to their places, for any
+ * placement of those tiles. Moves of the other tiles are free, so the values of different
+ * patterns can be added and the sum never overestimates the real number of moves.
+ *
+ * The tables are generated once with generate() and saved to a file. open() maps the file
+ * read only in memory, so starting a solver does not need to read or build anything and all
+ * the processes using the same file share the pages.
+ */
+class pattern_database {
+public:
+  static constexpr char magic[8] = {'1', '5', 'P', 'D', 'B', 0, 0, 1};
+  static constexpr std::size_t max_patterns = 15;
+  static constexpr std::size_t header_size = 4096;
+
+  pattern_database(const pattern_database &) = delete;
+  pattern_database(pattern_database &&other) : data_{other.data_}, size_{other.size_}, tables_{std::move(other.tables_)}, pattern_of_{other.pattern_of_} {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+
+  pattern_database &operator=(const pattern_database &) = delete;
+  pattern_database &operator=(pattern_database &&other) {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(tables_, other.tables_);
+    std::swap(pattern_of_, other.pattern_of_);
+    return *this;
+  }
+
+  ~pattern_database() {
+    if (data_ != nullptr)
+      munmap(const_cast<uint8_t *>(data_), size_);
+  }
+
+  /**
+   * open maps a pattern database file in memory.
+   *
+   * \return the database or an empty optional if the file cannot be mapped or is not a
+   *         pattern database. errno describes the problem.
+   */
+  static std::optional<pattern_database> open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return {};
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < header_size) {
+      ::close(fd);
+      errno = EINVAL;
+      return {};
+    }
+
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+      return {};
+
+    pattern_database db{static_cast<const uint8_t *>(data), static_cast<std::size_t>(st.st_size)};
+    if (!db.read_header()) {
+      errno = EINVAL;
+      return {};
+    }
+
+    return {std::move(db)};
+  }
+
+  /**
+   * generate builds the tables of the patterns and writes them to a file.
+   *
+   * \param progress called after each distance of each pattern with the pattern index, the
+   *                 distance and the number of states found at that distance.
+   * \return false if the file cannot be written or a pattern has more than max_pattern_tiles
+   *         tiles. errno describes the problem.
+   */
+  template <class Progress> static bool generate(const std::vector<pattern> &patterns, const std::string &path, Progress &&progress) {
+    if (patterns.size() > max_patterns ||
+        std::any_of(patterns.begin(), patterns.end(), [](const pattern &p) { return p.empty() || p.size() > std::size_t{max_pattern_tiles}; })) {
+      errno = EINVAL;
+      return false;
+    }
+
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+      return false;
+
+    file_header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.patterns = patterns.size();
+    uint64_t offset = header_size;
+    for (std::size_t i = 0; i < patterns.size(); i++) {
+      header.pattern[i].offset = offset;
+      header.pattern[i].entries = table_size(patterns[i].size());
+      header.pattern[i].tile_count = patterns[i].size();
+      for (std::size_t t = 0; t < patterns[i].size(); t++)
+        header.pattern[i].tiles[t] = patterns[i][t];
+      offset += (header.pattern[i].entries + header_size - 1) / header_size * header_size;
+    }
+
+    std::vector<uint8_t> page(header_size, 0);
+    std::memcpy(page.data(), &header, sizeof(header));
+    bool ok = std::fwrite(page.data(), 1, page.size(), file) == page.size();
+
+    for (std::size_t i = 0; ok && i < patterns.size(); i++) {
+      auto table = build_table(patterns[i], [&](int distance, uint64_t states) { progress(i, distance, states); });
+      table.resize((table.size() + header_size - 1) / header_size * header_size, 0);
+      ok = std::fwrite(table.data(), 1, table.size(), file) == table.size();
+    }
+
+    return std::fclose(file) == 0 && ok;
+  }
+
+  /**
+   * evaluate adds the values of the patterns for the board.
+   */
+  int evaluate(Board b) const {
+    std::array<uint8_t, 16> position_of;
+    for (int position = 0; position < 16; position++, b >>= 4)
+      position_of[b & 0xfull] = position;
+
+    int sum = 0;
+    for (const auto &table : tables_) {
+      std::array<uint8_t, 15> positions;
+      for (int i = 0; i < table.tile_count; i++)
+        positions[i] = position_of[table.tiles[i]];
+      sum += table.values[rank(positions.data(), table.tile_count)];
+    }
+    return sum;
+  }
+
+  /**
+   * update only looks up the table of the pattern that has the moved tile, before and after
+   * the move. The values of the other patterns don't change.
+   */
+  int update(int value, const tile_move &m) const {
+    const table &t = tables_[pattern_of_[m.tile]];
+    Board b = m.board;
+    std::array<uint8_t, 16> position_of;
+    for (int position = 0; position < 16; position++, b >>= 4)
+      position_of[b & 0xfull] = position;
+
+    std::array<uint8_t, 15> positions;
+    for (int i = 0; i < t.tile_count; i++)
+      positions[i] = position_of[t.tiles[i]];
+    int after = t.values[rank(positions.data(), t.tile_count)];
+
+    for (int i = 0; i < t.tile_count; i++)
+      if (t.tiles[i] == m.tile)
+        positions[i] = m.from;
+    int before = t.values[rank(positions.data(), t.tile_count)];
+
+    return value - before + after;
+  }
+
+  std::size_t patterns() const { return tables_.size(); }
+
+  /**
+   * returns the tiles of the pattern i.
+   */
+  pattern tiles(std::size_t i) const { return pattern(tables_[i].tiles.begin(), tables_[i].tiles.begin() + tables_[i].tile_count); }
+
+  std::size_t bytes() const { return size_; }
+
+  /**
+   * fingerprint is a hash of the header, with the patterns and the layout of the tables, so a
+   * search saved with a database is not resumed with another one.
+   */
+  uint64_t fingerprint() const {
+    uint64_t h = 0;
+    for (std::size_t offset = 0; offset < header_size; offset += sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, data_ + offset, sizeof(word));
+      h = board_hash(h ^ word);
+    }
+    return h;
+  }
+
+  /**
+   * returns the number of entries of a table for a pattern of k tiles: 16! / (16 - k)!
+   */
+  static constexpr uint64_t table_size(std::size_t k) {
+    uint64_t size = 1;
+    for (std::size_t i = 0; i < k; i++)
+      size *= 16 - i;
+    return size;
+  }
+
+private:
+  struct file_header {
+    char magic[8];
+    uint32_t patterns;
+    uint32_t reserved;
+    struct {
+      uint64_t offset;
+      uint64_t entries;
+      uint8_t tile_count;
+      uint8_t tiles[15];
+    } pattern[max_patterns];
+  };
+
+  static_assert(sizeof(file_header) <= header_size);
+
+  struct table {
+    const uint8_t *values;
+    int tile_count;
+    std::array<uint8_t, 15> tiles;
+  };
+
+  pattern_database(const uint8_t *data, std::size_t size) : data_{data}, size_{size} {}
+
+  bool read_header() {
+    file_header header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.patterns > max_patterns)
+      return false;
+
+    unsigned seen = 0;
+    for (uint32_t i = 0; i < header.patterns; i++) {
+      const auto &p = header.pattern[i];
+      if (p.tile_count == 0 || p.tile_count > max_pattern_tiles || p.entries != table_size(p.tile_count) || p.offset + p.entries > size_)
+        return false;
+
+      table t{data_ + p.offset, p.tile_count, {}};
+      for (int tile = 0; tile < p.tile_count; tile++) {
+        if (p.tiles[tile] == 0 || p.tiles[tile] > 15 || (seen & (1u << p.tiles[tile])))
+          return false;
+        seen |= 1u << p.tiles[tile];
+        t.tiles[tile] = p.tiles[tile];
+        pattern_of_[p.tiles[tile]] = i;
+      }
+      tables_.push_back(t);
+    }
+
+    // Every tile must be in a pattern, so update always finds its table
+    return seen == 0xfffe;
+  }
+
+  /**
+   * ranks a list of different positions (0 to 15): the index of the arrangement among all the
+   * arrangements of positions.size() positions out of 16.
+   */
+  static uint32_t rank(const uint8_t *positions, std::size_t count) {
+    uint32_t index = 0;
+    uint32_t used = 0;
+    for (std::size_t i = 0; i < count; i++) {
+      int p = positions[i];
+      index = index * (16 - i) + p - __builtin_popcount(used & ((1u << p) - 1));
+      used |= 1u << p;
+    }
+    return index;
+  }
+
+  static void unrank(uint32_t index, uint8_t *positions, std::size_t count) {
+    std::array<uint8_t, 16> digits;
+    for (std::size_t i = count; i-- > 0;) {
+      digits[i] = index % (16 - i);
+      index /= 16 - i;
+    }
+
+    uint32_t used = 0;
+    for (std::size_t i = 0; i < count; i++) {
+      // the position is the digits[i]-th free position
+      int p = 0;
+      for (int free = digits[i]; (used & (1u << p)) || free > 0; p++)
+        if (!(used & (1u << p)))
+          free--;
+      positions[i] = p;
+      used |= 1u << p;
+    }
+  }
+
+  /**
+   * build_table runs a breadth first search from the solved board over the states made of the
+   * positions of the pattern tiles plus the position of the hole. Moving a pattern tile costs
+   * one move and moving any other tile is free, so each distance is completed with the free
+   * moves before going to the next one (a 0-1 BFS by layers). The table keeps, for each
+   * placement of the pattern tiles, the minimum over all the positions of the hole.
+   */
+  template <class Progress> static std::vector<uint8_t> build_table(const pattern &tiles, Progress &&progress) {
+    constexpr uint8_t unknown = 0xff;
+    const std::size_t k = tiles.size();
+    std::vector<uint8_t> distance(table_size(k + 1), unknown);
+
+    std::array<uint8_t, 16> state;
+    for (std::size_t i = 0; i < k; i++)
+      state[i] = 16 - tiles[i];
+    state[k] = 0;
+
+    std::vector<uint32_t> current{rank(state.data(), k + 1)};
+    std::vector<uint32_t> next;
+    distance[current[0]] = 0;
+
+    for (int d = 0; !current.empty(); d++) {
+      uint64_t found = 0;
+      // current grows while it is processed with the states reached by free moves
+      for (std::size_t i = 0; i < current.size(); i++) {
+        uint32_t index = current[i];
+        if (distance[index] != d)
+          continue;
+        found++;
+
+        unrank(index, state.data(), k + 1);
+        int hole = state[k];
+        coord hole_coord = position_to_coord(hole);
+
+        for (auto dir : directions) {
+          coord dest = hole_coord + direction_to_coord[dir];
+          if (dest.x < 0 || dest.x > 3 || dest.y < 0 || dest.y > 3)
+            continue;
+          int dest_pos = coord_to_position(dest);
+
+          std::array<uint8_t, 16> child = state;
+          child[k] = dest_pos;
+          std::size_t moved = k;
+          for (std::size_t t = 0; t < k; t++)
+            if (state[t] == dest_pos)
+              moved = t;
+
+          if (moved == k) {
+            uint32_t child_index = rank(child.data(), k + 1);
+            if (distance[child_index] > d) {
+              distance[child_index] = d;
+              current.push_back(child_index);
+            }
+          } else {
+            child[moved] = hole;
+            uint32_t child_index = rank(child.data(), k + 1);
+            if (distance[child_index] == unknown) {
+              distance[child_index] = d + 1;
+              next.push_back(child_index);
+            }
+          }
+        }
+      }
+
+      progress(d, found);
+      current.swap(next);
+      next.clear();
+    }
+
+    // The position of the hole is the last digit of the rank, so the 16 - k entries with the
+    // same pattern placement are consecutive.
+    std::vector<uint8_t> table(table_size(k));
+    for (std::size_t i = 0; i < table.size(); i++) {
+      uint8_t best = unknown;
+      for (std::size_t hole = 0; hole < 16 - k; hole++)
+        best = std::min(best, distance[i * (16 - k) + hole]);
+      table[i] = best;
+    }
+
+    return table;
+  }
+
+  const uint8_t *data_ = nullptr;
+  std::size_t size_ = 0;
+  std::vector<table> tables_;
+  std::array<uint8_t, 16> pattern_of_{};
+};
@@ -0,0 +1,64 @@
+#include "pattern_database.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+int main(int argc, const char **argv) {
+  std::string partition = "6-6-3";
+  std::string output = "15puzzle.pdb";
+
+  using namespace std::literals;
+
+  for (int arg = 1; arg < argc; arg++) {
+    if ("--partition"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        partition = argv[++arg];
+      } else {
+        std::cerr << "No partition found" << std::endl;
+        return 1;
+      }
+    } else if ("--output"sv == argv[arg]) {
+      if ((arg + 1) < argc) {
+        output = argv[++arg];
+      } else {
+        std::cerr << "No output file found" << std::endl;
+        return 1;
+      }
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--partition 6-6-3|7-8|1,2,5,6/3,4,7,8/...] [--output file]" << std::endl;
+      return 1;
+    }
+  }
+
+  auto patterns = parse_partition(partition);
+  if (!patterns) {
+    std::cerr << "Invalid partition " << partition << ", the patterns have at most " << max_pattern_tiles << " tiles" << std::endl;
+    return 1;
+  }
+
+  auto start_time = std::chrono::system_clock::now();
+  bool ok = pattern_database::generate(*patterns, output, [&](std::size_t pattern, int distance, uint64_t states) {
+    std::chrono::duration<double> diff = std::chrono::system_clock::now() - start_time;
+    std::cout << "pattern = " << pattern << "; distance = " << distance << "; states = " << states << "; duration = " << diff.count() << std::endl;
+  });
+
+  if (!ok) {
+    std::cerr << "Cannot write " << output << ": " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+
+  auto db = pattern_database::open(output);
+  if (!db) {
+    std::cerr << "Cannot load " << output << ": " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+
+  std::cout << "Patterns  : " << db->patterns() << std::endl;
+  std::cout << "Size      : " << db->bytes() << " bytes" << std::endl;
+
+  return 0;
+}
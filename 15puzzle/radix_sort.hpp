@@ -0,0 +1,79 @@
+#pragma once
+
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * parallel_chunks splits [0, size) in one chunk per thread and calls f(thread, begin, end)
+ * for every chunk, each one in its own thread. With one thread, f is called in the caller.
+ */
+template <class F> void parallel_chunks(unsigned threads, std::size_t size, F &&f) {
+  threads = std::max(threads, 1u);
+  if (threads == 1) {
+    f(0u, std::size_t{0}, size);
+    return;
+  }
+
+  std::atomic<unsigned> next = 0;
+  laparca::thread_pool pool(threads, [&]() {
+    unsigned t = next++;
+    f(t, size * t / threads, size * (t + 1) / threads);
+  });
+  pool.join();
+}
+
+/**
+ * parallel_radix_sort sorts the values with a least significant digit radix sort, one byte
+ * per pass. In every pass each thread counts the bytes of its chunk, the counts give every
+ * thread the place of each byte in the output and then the threads move their values there,
+ * so the passes are stable and the threads never write to the same place.
+ *
+ * The passes where all the values have the same byte are skipped.
+ *
+ * \param threads the threads used. Small inputs use less threads.
+ */
+inline void parallel_radix_sort(std::vector<uint64_t> &values, unsigned threads) {
+  constexpr std::size_t min_chunk = 1 << 16;
+  threads = static_cast<unsigned>(std::clamp<std::size_t>(values.size() / min_chunk, 1, std::max(threads, 1u)));
+
+  std::vector<uint64_t> buffer(values.size());
+  std::vector<std::array<std::size_t, 256>> counts(threads);
+
+  for (int shift = 0; shift < 64; shift += 8) {
+    parallel_chunks(threads, values.size(), [&](unsigned t, std::size_t begin, std::size_t end) {
+      auto &count = counts[t];
+      count.fill(0);
+      for (std::size_t i = begin; i < end; i++)
+        count[(values[i] >> shift) & 0xff]++;
+    });
+
+    // The counts become the first place of each byte for each thread
+    std::size_t offset = 0;
+    bool is_sorted = false;
+    for (int digit = 0; digit < 256; digit++) {
+      std::size_t digit_size = 0;
+      for (unsigned t = 0; t < threads; t++) {
+        std::size_t count = counts[t][digit];
+        counts[t][digit] = offset;
+        offset += count;
+        digit_size += count;
+      }
+      is_sorted = is_sorted || digit_size == values.size();
+    }
+    if (is_sorted)
+      continue;
+
+    parallel_chunks(threads, values.size(), [&](unsigned t, std::size_t begin, std::size_t end) {
+      auto &place = counts[t];
+      for (std::size_t i = begin; i < end; i++)
+        buffer[place[(values[i] >> shift) & 0xff]++] = values[i];
+    });
+    values.swap(buffer);
+  }
+}
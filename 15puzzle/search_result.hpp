@@ -0,0 +1,32 @@
+#pragma once
+
+#include "board.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * search_result is what the solvers return: if a solution was found, the moves of
+ * the hole that solve the board and the work done to find them.
+ */
+struct search_result {
+  bool solved = false;
+  std::vector<Direction> moves;
+  uint64_t expanded = 0;
+  uint64_t generated = 0;
+};
+
+template <class Stream> Stream &operator<<(Stream &s, const std::vector<Direction> &moves) {
+  bool has_comma = false;
+  s << "[ ";
+  for (auto d : moves) {
+    if (has_comma)
+      s << ", ";
+    else
+      has_comma = true;
+    s << d;
+  }
+  s << " ]";
+
+  return s;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "heuristic.hpp"
+#include "sliding_puzzle.hpp"
+
+#include <array>
+#include <cstdint>
+
+/* The heuristics of heuristic.hpp for any sliding_puzzle. They have the same members, with
+ * the board and the move of the puzzle:
+ *
+ *     int evaluate(typename Puzzle::board_type b) const;
+ *     int update(int value, const typename Puzzle::tile_move &m) const;
+ */
+
+/**
+ * sliding_manhattan is the Manhattan distance of any puzzle, with its distances in a constexpr
+ * table for each size.
+ *
+ * \tparam Puzzle a sliding_puzzle.
+ */
+template <class Puzzle> struct sliding_manhattan {
+  using board_type = typename Puzzle::board_type;
+
+  /**
+   * distance[tile][position] is the Manhattan distance from position to the place of tile in
+   * the solved board. It is 0 for the hole.
+   */
+  static constexpr std::array<std::array<uint8_t, Puzzle::cells>, Puzzle::cells> distance = [] {
+    std::array<std::array<uint8_t, Puzzle::cells>, Puzzle::cells> table{};
+    for (int tile = 1; tile < Puzzle::cells; tile++) {
+      int goal = Puzzle::cells - tile;
+      for (int position = 0; position < Puzzle::cells; position++) {
+        int dx = position % Puzzle::width - goal % Puzzle::width;
+        int dy = position / Puzzle::width - goal / Puzzle::width;
+        table[tile][position] = (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+      }
+    }
+    return table;
+  }();
+
+  int evaluate(board_type b) const {
+    int sum = 0;
+    for (int position = 0; position < Puzzle::cells; position++)
+      sum += distance[Puzzle::tile_at(b, position)][position];
+    return sum;
+  }
+
+  int update(int value, const typename Puzzle::tile_move &m) const { return value - distance[m.tile][m.from] + distance[m.tile][m.to]; }
+};
+
+/**
+ * sliding_linear_conflict is the Manhattan distance plus the linear conflicts of any puzzle,
+ * as linear_conflict_heuristic. The lines are at most 5 positions, so their conflicts are
+ * computed when they are needed instead of read from tables; a move only changes the
+ * conflicts of the two lines it crosses. The 15 puzzle has tables, see the specialization
+ * below.
+ *
+ * \tparam Puzzle a sliding_puzzle.
+ */
+template <class Puzzle> class sliding_linear_conflict {
+public:
+  using board_type = typename Puzzle::board_type;
+
+  int evaluate(board_type b) const {
+    int sum = manhattan_.evaluate(b);
+    for (int row = 0; row < Puzzle::height; row++)
+      sum += row_conflicts(b, row);
+    for (int column = 0; column < Puzzle::width; column++)
+      sum += column_conflicts(b, column);
+    return sum;
+  }
+
+  int update(int value, const typename Puzzle::tile_move &m) const {
+    board_type before = (m.board & ~(Puzzle::cell_mask << (Puzzle::bits * m.to))) | (board_type{m.tile} << (Puzzle::bits * m.from));
+    value = manhattan_.update(value, m);
+    if (m.from / Puzzle::width == m.to / Puzzle::width) {
+      for (int column : {m.from % Puzzle::width, m.to % Puzzle::width})
+        value += column_conflicts(m.board, column) - column_conflicts(before, column);
+    } else {
+      for (int row : {m.from / Puzzle::width, m.to / Puzzle::width})
+        value += row_conflicts(m.board, row) - row_conflicts(before, row);
+    }
+    return value;
+  }
+
+private:
+  static int row_conflicts(board_type b, int row) {
+    int goals[Puzzle::width];
+    for (int x = 0; x < Puzzle::width; x++) {
+      int tile = Puzzle::tile_at(b, row * Puzzle::width + x);
+      int goal = Puzzle::cells - tile;
+      goals[x] = tile != 0 && goal / Puzzle::width == row ? goal % Puzzle::width : -1;
+    }
+    return line_conflict_penalty(goals);
+  }
+
+  static int column_conflicts(board_type b, int column) {
+    int goals[Puzzle::height];
+    for (int y = 0; y < Puzzle::height; y++) {
+      int tile = Puzzle::tile_at(b, y * Puzzle::width + column);
+      int goal = Puzzle::cells - tile;
+      goals[y] = tile != 0 && goal % Puzzle::width == column ? goal / Puzzle::width : -1;
+    }
+    return line_conflict_penalty(goals);
+  }
+
+  sliding_manhattan<Puzzle> manhattan_;
+};
+
+/**
+ * The 15 puzzle uses the heuristics of heuristic.hpp, that have tables for its lines.
+ */
+template <> struct sliding_manhattan<fifteen_puzzle> : manhattan_heuristic {};
+
+template <> class sliding_linear_conflict<fifteen_puzzle> : public linear_conflict_heuristic {};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "board.hpp"
+#include "search_result.hpp"
+#include "sliding_puzzle.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+/**
+ * sliding_ida_star is ida_star for any sliding_puzzle: the same iterations and the same
+ * stack of frames, with the board, the moves and the solved board of the puzzle.
+ *
+ * \tparam Puzzle a sliding_puzzle.
+ * \tparam Heuristic a heuristic of the puzzle, as described in sliding_heuristic.hpp.
+ */
+template <class Puzzle, class Heuristic> class sliding_ida_star {
+public:
+  using board_type = typename Puzzle::board_type;
+
+  static constexpr uint64_t unlimited = std::numeric_limits<uint64_t>::max();
+
+  /**
+   * max_depth is the longest solution it can find. Every 24 puzzle board is solved in less
+   * than 210 moves.
+   */
+  static constexpr int max_depth = 256;
+
+  explicit sliding_ida_star(const Heuristic &heuristic) : heuristic_{heuristic} {}
+
+  /**
+   * solve searches the moves that solve the board.
+   *
+   * \param max_nodes the search stops after expanding this number of nodes.
+   * \param on_iteration called at the end of every iteration with the bound used and the number of
+   *                     nodes expanded in it.
+   */
+  template <class Observer> search_result solve(board_type initial, uint64_t max_nodes, Observer &&on_iteration) {
+    search_result result;
+    if (!Puzzle::is_solvable(initial))
+      return result;
+
+    if (initial == Puzzle::goal) {
+      result.solved = true;
+      return result;
+    }
+
+    int bound = heuristic_.evaluate(initial);
+    while (true) {
+      uint64_t expanded_before = result.expanded;
+      int next_bound = std::numeric_limits<int>::max();
+      bool finished = search(initial, bound, next_bound, max_nodes, result);
+
+      on_iteration(bound, result.expanded - expanded_before);
+
+      if (finished || next_bound == std::numeric_limits<int>::max() || next_bound > max_depth)
+        return result;
+
+      bound = next_bound;
+    }
+  }
+
+  search_result solve(board_type initial, uint64_t max_nodes = unlimited) {
+    return solve(initial, max_nodes, [](int, uint64_t) {});
+  }
+
+private:
+  struct frame {
+    board_type board;
+    int h;
+    Direction from;
+    uint8_t next;
+  };
+
+  bool search(board_type initial, int bound, int &next_bound, uint64_t max_nodes, search_result &result) {
+    int depth = 0;
+    stack_[0] = {initial, heuristic_.evaluate(initial), Nothing, 0};
+
+    while (depth >= 0) {
+      frame &current = stack_[depth];
+      if (current.next == 4) {
+        depth--;
+        continue;
+      }
+
+      Direction d = static_cast<Direction>(current.next++);
+      if (d == inverse(current.from))
+        continue;
+
+      auto child = Puzzle::move(current.board, d);
+      if (!child)
+        continue;
+
+      result.generated++;
+      int h = heuristic_.update(current.h, *child);
+      int f = depth + 1 + h;
+      if (f > bound) {
+        next_bound = std::min(next_bound, f);
+        continue;
+      }
+
+      if (child->board == Puzzle::goal) {
+        result.solved = true;
+        result.moves.clear();
+        for (int i = 1; i <= depth; i++)
+          result.moves.push_back(stack_[i].from);
+        result.moves.push_back(d);
+        return true;
+      }
+
+      if (depth + 1 >= max_depth)
+        continue;
+
+      stack_[++depth] = {child->board, h, d, 0};
+      if (++result.expanded >= max_nodes)
+        return true;
+    }
+
+    return false;
+  }
+
+  const Heuristic &heuristic_;
+  std::array<frame, max_depth> stack_;
+};
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "board.hpp"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * uint128 is the board of the puzzles with more than 16 positions.
+ */
+__extension__ typedef unsigned __int128 uint128;
+
+/**
+ * sliding_puzzle describes a puzzle of width x height positions. The boards are stored like
+ * the one of the 15 puzzle: bits bits per position, the position 0 is the lowest one and it is
+ * the bottom right corner, and the tile t goes to the position cells - t, so the hole goes to
+ * the position 0 and the board read from the highest position is the puzzle read left to right
+ * and top to bottom.
+ *
+ * The boards with up to 16 positions use 4 bits per position in a 64 bit value, the bigger ones
+ * (the 24 puzzle) use 5 bits in a 128 bit value. Every size has its own constexpr tables, and
+ * the 4x4 puzzle uses the kernels of playgroundcpp/board.hh, so its boards and its moves are
+ * the ones of board.hpp.
+ *
+ * The directions are the ones of board.hpp: the moves of the hole.
+ *
+ * \tparam Width the number of columns.
+ * \tparam Height the number of rows.
+ */
+template <int Width, int Height> struct sliding_puzzle {
+  static_assert(Width >= 2 && Height >= 2 && Width * Height <= 25, "the tiles must fit in 5 bits and the board in 128");
+
+  static constexpr int width = Width;
+  static constexpr int height = Height;
+  static constexpr int cells = Width * Height;
+  static constexpr int bits = cells <= 16 ? 4 : 5;
+
+  using board_type = std::conditional_t<cells * bits <= 64, uint64_t, uint128>;
+
+  static constexpr bool is_fifteen_puzzle = Width == 4 && Height == 4;
+
+  static constexpr board_type cell_mask = (board_type{1} << bits) - 1;
+
+  static constexpr board_type goal = [] {
+    board_type b = 0;
+    for (int position = 1; position < cells; position++)
+      b |= board_type(cells - position) << (bits * position);
+    return b;
+  }();
+
+  /**
+   * legal_moves[hole] has the bit d set when the hole can move in the direction d.
+   */
+  static constexpr std::array<uint8_t, cells> legal_moves = [] {
+    std::array<uint8_t, cells> table{};
+    for (int position = 0; position < cells; position++) {
+      int x = position % Width;
+      int y = position / Width;
+      table[position] = (y < Height - 1 ? 1 << Up : 0) | (x > 0 ? 1 << Right : 0) | (y > 0 ? 1 << Down : 0) | (x < Width - 1 ? 1 << Left : 0);
+    }
+    return table;
+  }();
+
+  /**
+   * offset[d] is the position of the moved tile relative to the hole.
+   */
+  static constexpr int offset[4] = {Width, -1, -Width, 1};
+
+  /**
+   * wide_tile_move is the tile_move of playgroundcpp/board.hh for the 128 bit boards.
+   */
+  struct wide_tile_move {
+    board_type board;
+    uint8_t tile;
+    uint8_t from;
+    uint8_t to;
+  };
+
+  /**
+   * tile_move describes a move: the new board, the tile that was moved and the positions it
+   * moved from and to. The 64 bit boards use the one of board.hpp, so the heuristics of the
+   * 15 puzzle take the moves of fifteen_puzzle.
+   */
+  using tile_move = std::conditional_t<std::is_same_v<board_type, uint64_t>, playgroundcpp::board::tile_move, wide_tile_move>;
+
+  static constexpr int tile_at(board_type b, int position) { return static_cast<int>((b >> (bits * position)) & cell_mask); }
+
+  static constexpr int hole_position(board_type b) {
+    if constexpr (is_fifteen_puzzle) {
+      return playgroundcpp::board::hole_position(b);
+    } else {
+      for (int position = 0; position < cells; position++)
+        if (tile_at(b, position) == 0)
+          return position;
+      return cells;
+    }
+  }
+
+  /**
+   * moves the hole, that is in the position hole. The move must be legal.
+   */
+  static constexpr tile_move move_hole(board_type b, int hole, Direction d) {
+    if constexpr (is_fifteen_puzzle) {
+      return playgroundcpp::board::move_hole(b, hole, d);
+    } else {
+      int from = hole + offset[d];
+      board_type tile = (b >> (bits * from)) & cell_mask;
+      return {(b & ~(cell_mask << (bits * from))) | (tile << (bits * hole)), static_cast<uint8_t>(tile), static_cast<uint8_t>(from),
+              static_cast<uint8_t>(hole)};
+    }
+  }
+
+  static constexpr std::optional<tile_move> move(board_type b, Direction d) {
+    int hole = hole_position(b);
+    if (hole >= cells || d == Nothing || !((legal_moves[hole] >> d) & 1))
+      return {};
+    return {move_hole(b, hole, d)};
+  }
+
+  /**
+   * counts the pairs of tiles that are in the wrong order reading the board from the highest
+   * position.
+   */
+  static constexpr int inversions(board_type b) {
+    uint32_t seen = 0;
+    int count = 0;
+    for (int position = cells - 1; position >= 0; position--) {
+      unsigned tile = tile_at(b, position);
+      if (tile != 0)
+        count += __builtin_popcount(seen >> tile);
+      seen |= (uint32_t{1} << tile) & ~uint32_t{1};
+    }
+    return count;
+  }
+
+  /**
+   * With an odd width, a vertical move of the hole jumps over an even number of tiles and the
+   * parity of the inversions never changes. With an even width, it changes in every vertical
+   * move, like the row of the hole, so their sum keeps its parity.
+   */
+  static constexpr bool is_solvable(board_type b) {
+    if constexpr (is_fifteen_puzzle)
+      return playgroundcpp::board::is_solvable(b);
+    else if constexpr (Width % 2 == 1)
+      return inversions(b) % 2 == 0;
+    else
+      return (inversions(b) + hole_position(b) / Width) % 2 == 0;
+  }
+
+  /**
+   * parse reads a board written as the list of its tiles in decimal, from the top left corner
+   * and row by row, with 0 for the hole, as parse_tiles does for the 15 puzzle.
+   *
+   * \return the board or an empty optional if the text is not a permutation of the tiles.
+   */
+  static std::optional<board_type> parse(std::string_view text) {
+    board_type b = 0;
+    int tiles = 0;
+    uint32_t seen = 0;
+    std::size_t i = 0;
+    while (i < text.size()) {
+      if (text[i] == ' ' || text[i] == '\t' || text[i] == ',') {
+        i++;
+        continue;
+      }
+
+      int value = 0;
+      int digits = 0;
+      for (; i < text.size() && text[i] >= '0' && text[i] <= '9' && digits < 3; i++, digits++)
+        value = value * 10 + (text[i] - '0');
+      if (digits == 0 || value >= cells || (i < text.size() && text[i] != ' ' && text[i] != '\t' && text[i] != ','))
+        return {};
+
+      if (++tiles > cells || (seen & (uint32_t{1} << value)))
+        return {};
+      seen |= uint32_t{1} << value;
+      b = (b << bits) | board_type(value);
+    }
+
+    if (tiles != cells)
+      return {};
+
+    return {b};
+  }
+
+  /**
+   * returns the tiles of the board as parse reads them.
+   */
+  static std::string to_string(board_type b) {
+    std::string text;
+    for (int position = cells - 1; position >= 0; position--) {
+      text += std::to_string(tile_at(b, position));
+      if (position != 0)
+        text += position % Width == 0 ? ", " : " ";
+    }
+    return text;
+  }
+};
+
+using eight_puzzle = sliding_puzzle<3, 3>;
+using fifteen_puzzle = sliding_puzzle<4, 4>;
+using twenty_four_puzzle = sliding_puzzle<5, 5>;
+
+static_assert(fifteen_puzzle::goal == solved_board);
+static_assert(eight_puzzle::goal == 0x1234'5678'0);
+static_assert(std::is_same_v<twenty_four_puzzle::board_type, uint128>);
+static_assert(twenty_four_puzzle::tile_at(twenty_four_puzzle::goal, 24) == 1);
+static_assert(eight_puzzle::legal_moves[0] == ((1 << Up) | (1 << Left)));
+static_assert(eight_puzzle::is_solvable(eight_puzzle::goal) && twenty_four_puzzle::is_solvable(twenty_four_puzzle::goal));
+static_assert(!eight_puzzle::is_solvable(0x2134'5678'0));
@@ -0,0 +1,351 @@
+#pragma once
+
+#include "board.hpp"
+#include "node_arena.hpp"
+#include "search_result.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+/**
+ * sma_star is an A* that never uses more than a fixed number of bytes, in the spirit of SMA*
+ * (Russell, "Efficient memory-bounded search methods"). All the memory is allocated when it is
+ * created: a pool of nodes and the heads of the open list. When the pool is full and a node
+ * must be expanded, the worst leaves of the open list (the biggest f, the oldest first) are
+ * forgotten to make room. A forgotten leaf leaves its f in its parent, and the parent goes back
+ * to the open list with the smallest f of the children it has forgotten, even if others are
+ * still in memory. When it is the best option again, only the forgotten children are generated.
+ *
+ * Every expansion frees at most four nodes, so there are no pauses to rebuild the open list.
+ *
+ * The search is a tree search like IDA*: there is no closed set and only the move back to the
+ * parent is discarded. The f of a child is never smaller than the one of its parent (pathmax),
+ * so the solution is optimal when the heuristic is admissible and the budget can hold the
+ * path of the solution.
+ *
+ * \tparam Heuristic a heuristic, as described in heuristic.hpp.
+ */
+template <class Heuristic> class sma_star {
+public:
+  static constexpr uint64_t unlimited = std::numeric_limits<uint64_t>::max();
+
+  /**
+   * max_f is the number of buckets of the open list. The nodes with a bigger f are treated as
+   * dead ends.
+   */
+  static constexpr uint16_t max_f = 1024;
+
+  /**
+   * \param max_bytes the memory that can be used by the nodes and the open list.
+   */
+  sma_star(const Heuristic &heuristic, std::size_t max_bytes)
+      : heuristic_{heuristic}, capacity_{max_bytes > open_bytes ? (max_bytes - open_bytes) / sizeof(node) : 0}, nodes_{new node[capacity_]},
+        open_{open_list{std::make_unique<bucket[]>(max_f)}, open_list{std::make_unique<bucket[]>(max_f)}} {}
+
+  /**
+   * solve searches the moves that solve the board. It fails if the budget cannot hold the path
+   * of the solution and the children of its nodes. When the budget holds the path but not the
+   * nodes with the same f around it, the same subtrees are forgotten and generated again many
+   * times, and only max_nodes ends the search.
+   *
+   * \param max_nodes the search stops after expanding this number of nodes.
+   */
+  search_result solve(Board initial, uint64_t max_nodes = unlimited) {
+    search_result result;
+    pruned_ = 0;
+    if (!is_board_solvable(initial) || capacity_ == 0)
+      return result;
+
+    reset();
+    uint16_t h = heuristic_.evaluate(initial);
+    push_open(allocate({initial, no_node, no_node, no_node, 0, h, h, infinite, 0, 0, Nothing, none}));
+
+    while (min_f() < max_f) {
+      const open_list &best = open_[leaves].min_f <= open_[parents].min_f ? open_[leaves] : open_[parents];
+      node_handle top = best.buckets[best.min_f].first;
+      node &current = nodes_[top];
+      if (current.board == solved_board) {
+        result.solved = true;
+        for (node_handle n = top; nodes_[n].direction != Nothing; n = nodes_[n].parent)
+          result.moves.push_back(nodes_[n].direction);
+        std::reverse(result.moves.begin(), result.moves.end());
+        return result;
+      }
+
+      if (result.expanded >= max_nodes)
+        return result;
+
+      remove_open(top);
+      current.forgotten_f = infinite;
+      result.expanded++;
+
+      // A node that is expanded again only generates the children that it forgot
+      tile_move moves[4];
+      Direction children_directions[4];
+      int count = 0;
+      for (auto d : directions) {
+        if (d == inverse(current.direction) || ((current.children | current.dead) & (1 << d)))
+          continue;
+        if (auto m = move_tile(current.board, d)) {
+          moves[count] = *m;
+          children_directions[count] = d;
+          count++;
+        }
+      }
+      result.generated += count;
+
+      // The node being expanded can go back to the open list if one of its children is forgotten
+      // here, but it is never forgotten itself
+      while (available() < static_cast<std::size_t>(count) && forget_worst(top)) {
+      }
+      if (available() < static_cast<std::size_t>(count)) {
+        // Not even the path to this node and its children fit in the budget
+        return result;
+      }
+
+      for (int i = 0; i < count; i++) {
+        uint16_t child_h = heuristic_.update(current.h, moves[i]);
+        uint32_t f = std::max<uint32_t>(current.g + 1 + child_h, current.f);
+        // A child that is not solved and whose path fills the budget can never be expanded
+        if (f >= max_f || (moves[i].board != solved_board && current.g + 2u >= capacity_)) {
+          current.dead |= 1 << children_directions[i];
+          continue;
+        }
+        push_open(allocate({moves[i].board, top, no_node, no_node, static_cast<uint16_t>(current.g + 1), child_h, static_cast<uint16_t>(f), infinite, 0, 0,
+                            children_directions[i], none}));
+        current.children |= 1 << children_directions[i];
+      }
+
+      // All the children were dead ends
+      if (current.children == 0 && current.queue == none)
+        forget(top, infinite);
+      // It went back to the open list as a leaf while its children were forgotten, and it has
+      // new ones
+      if (current.children != 0 && current.queue == leaves) {
+        remove_open(top);
+        push_open(top);
+      }
+    }
+
+    return result;
+  }
+
+  /**
+   * returns the number of nodes the budget can hold.
+   */
+  std::size_t capacity() const { return capacity_; }
+
+  /**
+   * returns the number of bytes allocated, that is never more than the budget.
+   */
+  std::size_t bytes() const { return capacity_ * sizeof(node) + open_bytes; }
+
+  /**
+   * returns the number of leaves forgotten by the last search.
+   */
+  uint64_t pruned() const { return pruned_; }
+
+private:
+  static constexpr uint16_t infinite = std::numeric_limits<uint16_t>::max();
+
+  /**
+   * A node is a leaf in the open list or an expanded node with some children in memory, that is
+   * also in the open list if it has forgotten others. The free nodes are linked by next.
+   */
+  struct node {
+    Board board;
+    node_handle parent;
+    node_handle previous;
+    node_handle next;
+    uint16_t g;
+    uint16_t h;
+    /**
+     * f is the f of the node with pathmax or, once it has forgotten children, the smallest f
+     * of them.
+     */
+    uint16_t f;
+    uint16_t forgotten_f;
+    /**
+     * children has the bit d set if the child of the direction d is in memory.
+     */
+    uint8_t children;
+    /**
+     * dead has the bit d set if the child of the direction d cannot lead to the solution.
+     */
+    uint8_t dead;
+    Direction direction;
+    /**
+     * queue is the open list of the node, or none.
+     */
+    uint8_t queue;
+  };
+
+  static_assert(sizeof(node) == 32);
+
+  /**
+   * The leaves with the same f are in a list. The new ones are added to the front, where the
+   * best ones are taken, and the worst ones are forgotten from the back.
+   */
+  struct bucket {
+    node_handle first = no_node;
+    node_handle last = no_node;
+  };
+
+  /**
+   * The leaves and the expanded nodes that have forgotten children are in different open lists,
+   * so the leaves to forget are found without walking over the others.
+   */
+  struct open_list {
+    std::unique_ptr<bucket[]> buckets;
+    uint16_t min_f = max_f;
+    uint16_t max_f = 0;
+  };
+
+  enum : uint8_t { leaves, parents, none };
+
+  static constexpr std::size_t open_bytes = 2 * sizeof(bucket) * max_f;
+
+  uint16_t min_f() const { return std::min(open_[leaves].min_f, open_[parents].min_f); }
+
+  void reset() {
+    for (auto &list : open_) {
+      for (uint16_t f = 0; f < max_f; f++)
+        list.buckets[f] = {};
+      list.min_f = max_f;
+      list.max_f = 0;
+    }
+    used_ = 0;
+    free_ = no_node;
+    free_count_ = 0;
+  }
+
+  std::size_t available() const { return capacity_ - used_ + free_count_; }
+
+  node_handle allocate(const node &value) {
+    node_handle n;
+    if (free_ != no_node) {
+      n = free_;
+      free_ = nodes_[n].next;
+      free_count_--;
+    } else {
+      n = static_cast<node_handle>(used_++);
+    }
+    nodes_[n] = value;
+    return n;
+  }
+
+  void push_open(node_handle n) {
+    node &value = nodes_[n];
+    value.queue = value.children == 0 ? leaves : parents;
+    open_list &list = open_[value.queue];
+    bucket &b = list.buckets[value.f];
+    value.previous = no_node;
+    value.next = b.first;
+    if (b.first != no_node)
+      nodes_[b.first].previous = n;
+    else
+      b.last = n;
+    b.first = n;
+    list.min_f = std::min(list.min_f, value.f);
+    list.max_f = std::max(list.max_f, value.f);
+  }
+
+  void remove_open(node_handle n) {
+    node &value = nodes_[n];
+    open_list &list = open_[value.queue];
+    value.queue = none;
+    bucket &b = list.buckets[value.f];
+    if (value.previous != no_node)
+      nodes_[value.previous].next = value.next;
+    else
+      b.first = value.next;
+    if (value.next != no_node)
+      nodes_[value.next].previous = value.previous;
+    else
+      b.last = value.previous;
+
+    if (b.first == no_node) {
+      while (list.min_f < max_f && list.buckets[list.min_f].first == no_node)
+        list.min_f++;
+      if (list.min_f == max_f)
+        list.max_f = 0;
+      else
+        while (list.buckets[list.max_f].first == no_node)
+          list.max_f--;
+    }
+  }
+
+  /**
+   * forgets the worst leaf of the open list that is not kept.
+   *
+   * \return false if there are no leaves to forget.
+   */
+  bool forget_worst(node_handle kept) {
+    const open_list &list = open_[leaves];
+    if (list.min_f == max_f)
+      return false;
+
+    node_handle n = list.buckets[list.max_f].last;
+    if (n == kept) {
+      n = nodes_[n].previous;
+      // The kept node is the only one of the worst bucket, the leaf to forget is in a better one
+      for (uint16_t f = list.max_f; n == no_node && f-- > list.min_f;)
+        n = list.buckets[f].last;
+      if (n == no_node)
+        return false;
+    }
+    uint16_t f = nodes_[n].f;
+    remove_open(n);
+    forget(n, f);
+    return true;
+  }
+
+  /**
+   * frees a node without children, that is not in the open list, and gives f to its parent.
+   * The parent goes to the open list with the best f of the subtrees it has forgotten. A parent
+   * left without children is forgotten too if all of them were dead ends.
+   */
+  void forget(node_handle n, uint16_t f) {
+    while (true) {
+      node_handle parent = nodes_[n].parent;
+      const Direction direction = nodes_[n].direction;
+      nodes_[n].next = free_;
+      free_ = n;
+      free_count_++;
+      pruned_++;
+      if (parent == no_node)
+        return;
+
+      node &p = nodes_[parent];
+      p.children &= ~(1 << direction);
+      if (f == infinite)
+        p.dead |= 1 << direction;
+      p.forgotten_f = std::min(p.forgotten_f, f);
+      if (p.forgotten_f < max_f) {
+        // The children in memory can have a smaller f than the ones forgotten before, and f is
+        // a lower bound of all the children that are not in memory
+        if (p.queue != none)
+          remove_open(parent);
+        p.f = p.forgotten_f;
+        push_open(parent);
+        return;
+      }
+      if (p.children != 0 || p.queue != none)
+        return;
+
+      n = parent;
+      f = infinite;
+    }
+  }
+
+  const Heuristic &heuristic_;
+  const std::size_t capacity_;
+  std::unique_ptr<node[]> nodes_;
+  open_list open_[2];
+  std::size_t used_ = 0;
+  node_handle free_ = no_node;
+  std::size_t free_count_ = 0;
+  uint64_t pruned_ = 0;
+};
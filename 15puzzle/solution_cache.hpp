@@ -0,0 +1,208 @@
+#pragma once
+
+#include "board.hpp"
+#include "closed_set.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <optional>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+/**
+ * solution_cache is a file of optimal solutions, mapped in memory, so the boards solved by a
+ * process are known by the next ones without searching again.
+ *
+ * A board and its transpose (see transpose in board.hpp) have the same solution with the
+ * directions transposed, so they share an entry: the key is the smaller of the two, and the
+ * moves are transposed when the board is not its own key.
+ *
+ * The file is an open addressing hash table with linear probing and a fixed number of slots,
+ * chosen when it is created. The writes go to the mapped pages, so they are in the file even
+ * if the process dies, but two processes must not write to the same file at the same time.
+ */
+class solution_cache {
+public:
+  static constexpr char magic[8] = {'1', '5', 'C', 'A', 'C', 'H', 'E', 1};
+  static constexpr std::size_t header_size = 4096;
+  /**
+   * max_moves is the longest solution stored, two bits per move. The optimal solutions of the
+   * 15 puzzle have at most 80 moves.
+   */
+  static constexpr std::size_t max_moves = 92;
+
+  solution_cache(const solution_cache &) = delete;
+  solution_cache(solution_cache &&other) : data_{other.data_}, size_{other.size_} {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+
+  solution_cache &operator=(const solution_cache &) = delete;
+  solution_cache &operator=(solution_cache &&other) {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    return *this;
+  }
+
+  ~solution_cache() {
+    if (data_ != nullptr)
+      munmap(data_, size_);
+  }
+
+  /**
+   * open maps a cache file in memory, creating it with room for slots entries if it does not
+   * exist. The slots of an existing file are the ones it was created with.
+   *
+   * \param slots the number of slots of a new file, rounded up to a power of two.
+   * \return the cache or an empty optional if the file cannot be created or mapped or is not a
+   *         cache. errno describes the problem.
+   */
+  static std::optional<solution_cache> open(const std::string &path, uint64_t slots = uint64_t{1} << 16) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+      return {};
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      ::close(fd);
+      return {};
+    }
+
+    // A new file is all zeros after ftruncate: every slot is empty
+    const bool created = st.st_size == 0;
+    if (created) {
+      uint64_t capacity = 1;
+      while (capacity < slots)
+        capacity *= 2;
+      st.st_size = header_size + capacity * sizeof(entry);
+      if (ftruncate(fd, st.st_size) != 0) {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        return {};
+      }
+    } else if (static_cast<std::size_t>(st.st_size) < header_size) {
+      ::close(fd);
+      errno = EINVAL;
+      return {};
+    }
+
+    void *data = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+      return {};
+
+    solution_cache c{static_cast<uint8_t *>(data), static_cast<std::size_t>(st.st_size)};
+    if (created) {
+      std::memcpy(c.header().magic, magic, sizeof(magic));
+      c.header().capacity = (st.st_size - header_size) / sizeof(entry);
+    }
+
+    const uint64_t capacity = c.header().capacity;
+    if (std::memcmp(c.header().magic, magic, sizeof(magic)) != 0 || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        header_size + capacity * sizeof(entry) != c.size_) {
+      errno = EINVAL;
+      return {};
+    }
+
+    return {std::move(c)};
+  }
+
+  /**
+   * find returns the solution of the board or an empty optional if it is not in the cache.
+   */
+  std::optional<std::vector<Direction>> find(Board b) const {
+    const Board key = std::min(b, transpose(b));
+    const entry *e = slot_of(key);
+    if (e->board != key)
+      return {};
+
+    std::vector<Direction> moves(e->length);
+    for (std::size_t i = 0; i < moves.size(); i++) {
+      const Direction d = static_cast<Direction>((e->moves[i / 4] >> (2 * (i % 4))) & 3);
+      moves[i] = key == b ? d : transpose(d);
+    }
+    return {moves};
+  }
+
+  /**
+   * insert stores the solution of the board, if the cache does not have a shorter one.
+   *
+   * \return false if the solution is too long or the cache is full.
+   */
+  bool insert(Board b, const std::vector<Direction> &moves) {
+    if (moves.size() > max_moves)
+      return false;
+
+    const Board key = std::min(b, transpose(b));
+    entry *e = slot_of(key);
+    if (e->board == key && e->length <= moves.size())
+      return true;
+    // The table is left with an empty slot for every 8, so the probes are short and always end
+    if (e->board != key && (header().entries + 1) * 8 > header().capacity * 7)
+      return false;
+
+    entry stored{key, static_cast<uint8_t>(moves.size()), {}};
+    for (std::size_t i = 0; i < moves.size(); i++)
+      stored.moves[i / 4] |= (key == b ? moves[i] : transpose(moves[i])) << (2 * (i % 4));
+    if (e->board != key)
+      header().entries++;
+    *e = stored;
+    return true;
+  }
+
+  /**
+   * returns the number of boards stored, a board and its transpose are one.
+   */
+  uint64_t size() const { return header().entries; }
+
+  uint64_t capacity() const { return header().capacity; }
+
+  std::size_t bytes() const { return size_; }
+
+private:
+  struct file_header {
+    char magic[8];
+    uint64_t capacity;
+    uint64_t entries;
+  };
+
+  static_assert(sizeof(file_header) <= header_size);
+
+  /**
+   * entry is a slot of the table. The board 0 is not a valid board, it marks the empty slots.
+   */
+  struct entry {
+    Board board;
+    uint8_t length;
+    uint8_t moves[(max_moves + 3) / 4];
+  };
+
+  static_assert(sizeof(entry) == 32);
+
+  solution_cache(uint8_t *data, std::size_t size) : data_{data}, size_{size} {}
+
+  file_header &header() const { return *reinterpret_cast<file_header *>(data_); }
+
+  entry *entries() const { return reinterpret_cast<entry *>(data_ + header_size); }
+
+  /**
+   * returns the slot of the key or the empty slot where it would be inserted.
+   */
+  entry *slot_of(Board key) const {
+    const uint64_t mask = header().capacity - 1;
+    for (uint64_t i = board_hash(key) & mask;; i = (i + 1) & mask)
+      if (entries()[i].board == key || entries()[i].board == 0)
+        return &entries()[i];
+  }
+
+  uint8_t *data_;
+  std::size_t size_;
+};
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "board.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * The solver protocol is the one of 15puzzle_daemon: text lines, ended with '\n', one request or
+ * one response per line. A request is a board, as it is printed, and optionally the limits of
+ * its search, the maximum number of expanded nodes and the maximum time in milliseconds (0 or
+ * nothing to use the limits of the daemon):
+ *
+ *     d2a31c845096feb7 1000000 250
+ *
+ * The responses start with the board, so the requests can be pipelined and answered out of
+ * order, then the status, the expanded nodes and the microseconds of the search. A solution
+ * also has its length and the moves of the hole, one letter each (- if there are none):
+ *
+ *     d2a31c845096feb7 solved 2361 940 41 RDLUULURRD...
+ *     d2a31c845096feb7 node-limit 1000000 90371
+ *
+ * A request that cannot be solved is answered with its board, "error" and the reason. If not
+ * even its board can be read, the answer starts with "error", then the reason and the line of
+ * the request, as it cannot be matched by its board:
+ *
+ *     0123456789abcdef error the board cannot be solved
+ *     error invalid request 0123456789abcdeg
+ */
+
+/**
+ * solve_request is a request of the solver protocol.
+ */
+struct solve_request {
+  Board board = solved_board;
+  uint64_t max_nodes = 0;
+  uint64_t max_milliseconds = 0;
+};
+
+enum class solve_status { solved, node_limit, time_limit, cancelled };
+
+/**
+ * solve_response is the answer to a solve_request.
+ */
+struct solve_response {
+  Board board = solved_board;
+  solve_status status = solve_status::solved;
+  uint64_t expanded = 0;
+  uint64_t microseconds = 0;
+  std::vector<Direction> moves;
+};
+
+/**
+ * direction_letters are the letters of the moves of the hole in the responses.
+ */
+constexpr char direction_letters[] = "URDL";
+
+constexpr std::string_view solve_status_names[] = {"solved", "node-limit", "time-limit", "cancelled"};
+
+/**
+ * next_protocol_field returns the next field of the line, separated by spaces, and removes it
+ * from the line. It is empty at the end of the line.
+ */
+inline std::string_view next_protocol_field(std::string_view &line) {
+  auto first = line.find_first_not_of(' ');
+  if (first == std::string_view::npos) {
+    line = {};
+    return {};
+  }
+  line.remove_prefix(first);
+  auto field = line.substr(0, line.find(' '));
+  line.remove_prefix(field.size());
+  return field;
+}
+
+/**
+ * parse_protocol_number reads a decimal number that is the whole field.
+ */
+inline bool parse_protocol_number(std::string_view field, uint64_t &value) {
+  auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+  return error == std::errc{} && end == field.data() + field.size();
+}
+
+/**
+ * protocol_board returns the board in hexadecimal with its 16 digits.
+ */
+inline std::string protocol_board(Board b) {
+  char text[17];
+  std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(b));
+  return text;
+}
+
+/**
+ * parse_request reads a request line, without its '\n'.
+ *
+ * \return the request or an empty optional if the line is not a request.
+ */
+inline std::optional<solve_request> parse_request(std::string_view line) {
+  solve_request request;
+  auto board = parse_board(next_protocol_field(line));
+  if (!board)
+    return {};
+  request.board = *board;
+
+  auto field = next_protocol_field(line);
+  if (!field.empty() && !parse_protocol_number(field, request.max_nodes))
+    return {};
+  field = next_protocol_field(line);
+  if (!field.empty() && !parse_protocol_number(field, request.max_milliseconds))
+    return {};
+
+  if (!next_protocol_field(line).empty())
+    return {};
+  return {request};
+}
+
+/**
+ * format_request returns the line of the request, with its '\n'.
+ */
+inline std::string format_request(const solve_request &request) {
+  return protocol_board(request.board) + " " + std::to_string(request.max_nodes) + " " + std::to_string(request.max_milliseconds) + "\n";
+}
+
+/**
+ * format_response returns the line of the response, with its '\n'.
+ */
+inline std::string format_response(const solve_response &response) {
+  std::string line = protocol_board(response.board) + " " + std::string{solve_status_names[static_cast<int>(response.status)]} + " " +
+                     std::to_string(response.expanded) + " " + std::to_string(response.microseconds);
+  if (response.status == solve_status::solved) {
+    line += " " + std::to_string(response.moves.size()) + " ";
+    for (auto d : response.moves)
+      line += direction_letters[d];
+    if (response.moves.empty())
+      line += "-";
+  }
+  return line + "\n";
+}
+
+/**
+ * format_error returns the error line that answers the request line, with its '\n'. It starts
+ * with the board of the request, if it can be read.
+ */
+inline std::string format_error(std::string_view request_line, std::string_view reason) {
+  std::string_view line = request_line;
+  if (auto board = parse_board(next_protocol_field(line)))
+    return protocol_board(*board) + " error " + std::string{reason} + "\n";
+  return "error " + std::string{reason} + " " + std::string{request_line} + "\n";
+}
+
+/**
+ * parse_response reads a response line, without its '\n'.
+ *
+ * \return the response or an empty optional if the line is an error or not a response.
+ */
+inline std::optional<solve_response> parse_response(std::string_view line) {
+  solve_response response;
+  auto board = parse_board(next_protocol_field(line));
+  if (!board)
+    return {};
+  response.board = *board;
+
+  auto status = next_protocol_field(line);
+  int s = 0;
+  while (s < 4 && solve_status_names[s] != status)
+    s++;
+  if (s == 4)
+    return {};
+  response.status = static_cast<solve_status>(s);
+
+  if (!parse_protocol_number(next_protocol_field(line), response.expanded) || !parse_protocol_number(next_protocol_field(line), response.microseconds))
+    return {};
+
+  if (response.status == solve_status::solved) {
+    uint64_t length;
+    if (!parse_protocol_number(next_protocol_field(line), length))
+      return {};
+    auto moves = next_protocol_field(line);
+    if (moves != "-") {
+      for (char c : moves) {
+        auto d = std::string_view{direction_letters}.find(c);
+        if (d == std::string_view::npos)
+          return {};
+        response.moves.push_back(static_cast<Direction>(d));
+      }
+    }
+    if (response.moves.size() != length)
+      return {};
+  }
+
+  if (!next_protocol_field(line).empty())
+    return {};
+  return {response};
+}
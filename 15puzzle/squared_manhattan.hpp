@@ -0,0 +1,58 @@
+#pragma once
+
+#include "board.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * squared_manhattan_distance is the square of the Manhattan distance between the coordinates.
+ */
+inline int squared_manhattan_distance(const coord &a, const coord &b) {
+  int d = std::abs(a.x - b.x) + std::abs(a.y - b.y);
+  return d * d;
+}
+
+/**
+ * squared_distance[value][position] is the square of the Manhattan distance from the position
+ * to the place of value in the solved board.
+ */
+inline const auto squared_distance = [] {
+  std::array<std::array<uint16_t, 16>, 16> table{};
+  for (int value = 0; value < 16; value++) {
+    for (int position = 0; position < 16; position++) {
+      int corrected_value = 15 - ((value + 15) % 16);
+
+      coord c_orig = position_to_coord(position);
+      coord c_dest = position_to_coord(corrected_value);
+
+      table[value][position] = squared_manhattan_distance(c_orig, c_dest);
+    }
+  }
+  return table;
+}();
+
+inline uint64_t manhattam_distances_sum_of(Board b) {
+  uint64_t sum = 0;
+  for (int position = 0; position < 16; position++, b >>= 4)
+    sum += squared_distance[b & 0xfull][position];
+  return sum;
+}
+
+/**
+ * squared_manhattan_heuristic is the sum of the squares of the Manhattan distances of the tiles,
+ * the heuristic the A* used before the admissible ones. It is not admissible: it overestimates
+ * the moves left, so the solutions found with it are not always optimal. It is kept for the
+ * comparisons, with --heuristic squared-manhattan.
+ */
+struct squared_manhattan_heuristic {
+  int evaluate(Board b) const { return manhattam_distances_sum_of(b); }
+
+  /**
+   * The tile goes from m.from to m.to and the hole, that is also counted, goes the other way.
+   */
+  int update(int value, const tile_move &m) const {
+    return value - squared_distance[m.tile][m.from] + squared_distance[m.tile][m.to] - squared_distance[0][m.to] + squared_distance[0][m.from];
+  }
+};
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+/**
+ * telemetry_dump_requested is set by request_telemetry_dump, that is installed as the handler
+ * of SIGUSR1. The sampler writes a snapshot when it sees it.
+ */
+inline volatile std::sig_atomic_t telemetry_dump_requested = 0;
+
+inline void request_telemetry_dump(int) { telemetry_dump_requested = 1; }
+
+/**
+ * telemetry_counter is a counter written by one thread and read by any. The writer adds with a
+ * relaxed load and store instead of an atomic read-modify-write, so counting costs the same as
+ * with a plain integer, and the readers never see a torn value.
+ */
+class telemetry_counter {
+public:
+  void add(uint64_t n) { value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+
+  void set(uint64_t n) { value_.store(n, std::memory_order_relaxed); }
+
+  uint64_t get() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint64_t> value_ = 0;
+};
+
+/**
+ * telemetry_histogram counts values in Buckets buckets, one per value. The bigger values are
+ * counted in the last one.
+ */
+template <std::size_t Buckets> class telemetry_histogram {
+public:
+  void record(uint64_t value) { counts_[std::min<uint64_t>(value, Buckets - 1)].add(1); }
+
+  uint64_t count(std::size_t bucket) const { return counts_[bucket].get(); }
+
+  /**
+   * writes the buckets that are not empty as a JSON array of [bucket, count] pairs.
+   */
+  void write_json(std::ostream &out) const {
+    out << '[';
+    bool has_comma = false;
+    for (std::size_t i = 0; i < Buckets; i++) {
+      uint64_t c = counts_[i].get();
+      if (c == 0)
+        continue;
+      if (has_comma)
+        out << ',';
+      has_comma = true;
+      out << '[' << i << ',' << c << ']';
+    }
+    out << ']';
+  }
+
+private:
+  std::array<telemetry_counter, Buckets> counts_;
+};
+
+/**
+ * search_telemetry is what a search reports while it runs: counters of its work, the sizes of
+ * its lists and histograms of the f and g of the expanded nodes and of the time to expand a
+ * node. The search writes it from its thread and a telemetry_sampler reads it from another.
+ *
+ * Timing every expansion would cost more than many expansions, so only one of every
+ * latency_sample_interval is timed; should_time tells which one.
+ */
+class search_telemetry {
+public:
+  static constexpr uint64_t latency_sample_interval = 64;
+
+  telemetry_counter expanded;
+  telemetry_counter generated;
+  /**
+   * duplicates counts the boards dropped because they were already reached with a path that
+   * is not longer, and pruned the moves that move_pruning discards without generating them.
+   */
+  telemetry_counter duplicates;
+  telemetry_counter pruned;
+  telemetry_counter open_size;
+  telemetry_counter closed_size;
+  telemetry_counter bytes;
+
+  telemetry_histogram<1024> f;
+  telemetry_histogram<256> g;
+  /**
+   * latency_ns counts the timed expansions by the log2 of their duration in nanoseconds.
+   */
+  telemetry_histogram<64> latency_ns;
+
+  void record_expansion(uint32_t node_f, uint32_t node_g) {
+    expanded.add(1);
+    f.record(node_f);
+    g.record(node_g);
+  }
+
+  bool should_time() const { return expanded.get() % latency_sample_interval == 0; }
+
+  void record_latency(std::chrono::nanoseconds duration) {
+    uint64_t ns = std::max<int64_t>(duration.count(), 1);
+    latency_ns.record(63 - __builtin_clzll(ns));
+  }
+
+  /**
+   * writes a JSON object in one line.
+   *
+   * \param event why it is written: sample, signal or final.
+   * \param seconds the time since the search began.
+   */
+  void write_json(std::ostream &out, const char *event, double seconds) const {
+    uint64_t e = expanded.get();
+    out << "{\"event\":\"" << event << "\",\"seconds\":" << seconds << ",\"expanded\":" << e << ",\"generated\":" << generated.get()
+        << ",\"duplicates\":" << duplicates.get() << ",\"pruned\":" << pruned.get() << ",\"open\":" << open_size.get() << ",\"closed\":" << closed_size.get() << ",\"bytes\":" << bytes.get()
+        << ",\"expanded_per_second\":" << (seconds > 0 ? e / seconds : 0) << ",\"f\":";
+    f.write_json(out);
+    out << ",\"g\":";
+    g.write_json(out);
+    out << ",\"latency_log2_ns\":";
+    latency_ns.write_json(out);
+    out << "}\n";
+    out.flush();
+  }
+};
+
+/**
+ * telemetry_sampler writes the telemetry of a search from its own thread: a JSON line every
+ * interval, another one when SIGUSR1 is received and a last one when it is stopped. The search
+ * never waits for it.
+ */
+class telemetry_sampler {
+public:
+  /**
+   * \param interval the time between samples. Zero only writes on signals and at the end.
+   */
+  telemetry_sampler(const search_telemetry &telemetry, std::ostream &out, std::chrono::milliseconds interval)
+      : telemetry_{telemetry}, out_{out}, interval_{interval}, start_{std::chrono::steady_clock::now()}, thread_{[this] { run(); }} {}
+
+  telemetry_sampler(const telemetry_sampler &) = delete;
+  telemetry_sampler &operator=(const telemetry_sampler &) = delete;
+
+  ~telemetry_sampler() { stop(); }
+
+  /**
+   * pause keeps the thread from sampling while the returned lock is held. The thread is then
+   * waiting, not writing with the locks of the stream or of the allocator, so the process can
+   * fork.
+   */
+  std::unique_lock<std::mutex> pause() { return std::unique_lock{mutex_}; }
+
+  /**
+   * stops the thread and writes the final sample.
+   */
+  void stop() {
+    {
+      std::lock_guard lock{mutex_};
+      if (stopped_)
+        return;
+      stopped_ = true;
+    }
+    wake_up_.notify_one();
+    thread_.join();
+    telemetry_.write_json(out_, "final", seconds());
+  }
+
+private:
+  /**
+   * The signal is polled every poll_interval.
+   */
+  static constexpr std::chrono::milliseconds poll_interval{50};
+
+  double seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count(); }
+
+  void run() {
+    auto next_sample = start_ + interval_;
+    std::unique_lock lock{mutex_};
+    while (!wake_up_.wait_for(lock, poll_interval, [this] { return stopped_; })) {
+      if (telemetry_dump_requested) {
+        telemetry_dump_requested = 0;
+        telemetry_.write_json(out_, "signal", seconds());
+      }
+
+      if (interval_.count() > 0 && std::chrono::steady_clock::now() >= next_sample) {
+        telemetry_.write_json(out_, "sample", seconds());
+        next_sample += interval_;
+      }
+    }
+  }
+
+  const search_telemetry &telemetry_;
+  std::ostream &out_;
+  const std::chrono::milliseconds interval_;
+  const std::chrono::steady_clock::time_point start_;
+  std::mutex mutex_;
+  std::condition_variable wake_up_;
+  bool stopped_ = false;
+  std::thread thread_;
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * unix_address fills the address of a Unix domain socket.
+ *
+ * \return false if the path does not fit in the address. errno is ENAMETOOLONG.
+ */
+inline bool unix_address(const std::string &path, sockaddr_un &address) {
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    errno = ENAMETOOLONG;
+    return false;
+  }
+  path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+  return true;
+}
+
+/**
+ * connect_unix connects to the Unix domain socket in the path.
+ *
+ * \return the socket or -1 if it cannot connect. errno describes the problem.
+ */
+inline int connect_unix(const std::string &path) {
+  sockaddr_un address;
+  if (!unix_address(path, address))
+    return -1;
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return -1;
+
+  if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+    int error = errno;
+    ::close(fd);
+    errno = error;
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * listen_unix creates a Unix domain socket listening in the path. A socket that is already in
+ * the path is only removed if nobody listens on it, it is the one of a process that has ended.
+ *
+ * \return the socket or -1 if it cannot be created. errno describes the problem, EADDRINUSE if
+ *         there is another file in the path or another process listens on it.
+ */
+inline int listen_unix(const std::string &path, int backlog = 128) {
+  sockaddr_un address;
+  if (!unix_address(path, address))
+    return -1;
+
+  struct stat st;
+  if (lstat(path.c_str(), &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) {
+      errno = EADDRINUSE;
+      return -1;
+    }
+    int other = connect_unix(path);
+    if (other >= 0 || errno != ECONNREFUSED) {
+      if (other >= 0)
+        ::close(other);
+      errno = EADDRINUSE;
+      return -1;
+    }
+    ::unlink(path.c_str());
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return -1;
+
+  if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(fd, backlog) != 0) {
+    int error = errno;
+    ::close(fd);
+    errno = error;
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * send_all writes all the text to the socket. A closed peer is an error, not a SIGPIPE.
+ *
+ * \return false if the text could not be written. errno describes the problem.
+ */
+inline bool send_all(int fd, std::string_view text) {
+  while (!text.empty()) {
+    ssize_t written = ::send(fd, text.data(), text.size(), MSG_NOSIGNAL);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    text.remove_prefix(written);
+  }
+  return true;
+}
+
+/**
+ * line_reader splits the bytes read from a socket in lines.
+ */
+class line_reader {
+public:
+  static constexpr std::size_t max_line = 4096;
+
+  /**
+   * read reads the bytes that are available in the socket, blocking if there are none.
+   *
+   * \return false at the end of the stream, on errors or if a line is longer than max_line.
+   */
+  bool read(int fd) {
+    char data[4096];
+    ssize_t size;
+    do
+      size = ::recv(fd, data, sizeof(data), 0);
+    while (size < 0 && errno == EINTR);
+    if (size <= 0)
+      return false;
+
+    buffer_.append(data, size);
+    return buffer_.size() - start_ <= max_line || buffer_.find('\n', start_) != std::string::npos;
+  }
+
+  /**
+   * next takes the next complete line, without its '\n' nor a '\r' before it.
+   *
+   * \return false if there isn't a complete line yet.
+   */
+  bool next(std::string &line) {
+    auto end = buffer_.find('\n', start_);
+    if (end == std::string::npos) {
+      buffer_.erase(0, start_);
+      start_ = 0;
+      return false;
+    }
+
+    line.assign(buffer_, start_, end - start_);
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    start_ = end + 1;
+    return true;
+  }
+
+private:
+  std::string buffer_;
+  std::size_t start_ = 0;
+};
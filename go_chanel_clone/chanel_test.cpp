@@ -96,6 +96,79 @@ TEST(chanelN_test, normal_behaviour) {
   ASSERT_EQ(c.pop(), std::optional<size_t>{43});
 }
 
+TEST(chanelN_test, try_push_and_try_pop) {
+  laparca::chanelN<std::vector<size_t>> c(2);
+  ASSERT_FALSE(c.try_pop().has_value());
+
+  ASSERT_TRUE(c.try_push(std::vector<size_t>{1, 2}));
+  ASSERT_TRUE(c.try_push(std::vector<size_t>{3}));
+
+  // A full chanel doesn't take the value
+  std::vector<size_t> v{4};
+  ASSERT_FALSE(c.try_push(std::move(v)));
+  ASSERT_EQ(v.size(), 1);
+
+  ASSERT_EQ(c.try_pop(), (std::optional<std::vector<size_t>>{{1, 2}}));
+  ASSERT_TRUE(c.try_push(std::move(v)));
+  ASSERT_EQ(c.try_pop(), (std::optional<std::vector<size_t>>{{3}}));
+  ASSERT_EQ(c.try_pop(), (std::optional<std::vector<size_t>>{{4}}));
+  ASSERT_FALSE(c.try_pop().has_value());
+
+  c.close();
+  ASSERT_FALSE(c.try_push(std::vector<size_t>{5}));
+}
+
+TEST(chanelN_test, try_pop_with_producers) {
+  laparca::chanelN<size_t> c(4);
+  constexpr size_t totalElements = 10'000;
+  constexpr size_t numProducers = 4;
+
+  laparca::thread_pool producers(numProducers, [&c]() {
+    for (size_t i = 0; i < totalElements / numProducers; i++)
+      while (!c.try_push(1))
+        std::this_thread::yield();
+  });
+
+  size_t received = 0;
+  while (received < totalElements) {
+    if (auto value = c.try_pop())
+      received += *value;
+    else
+      std::this_thread::yield();
+  }
+
+  producers.join();
+  ASSERT_EQ(received, totalElements);
+  ASSERT_FALSE(c.try_pop().has_value());
+}
+
+TEST(chanelN_test, try_push_does_not_wait_for_a_blocked_writer) {
+  // A single slot: the blocking writer claims it while it is full and waits for it, so the
+  // try_push of the reader finds it taken and must fail, as no one else would read it
+  laparca::chanelN<size_t> c(1);
+  constexpr size_t totalElements = 100'000;
+
+  std::thread writer{[&c] {
+    for (size_t i = 0; i < totalElements; i++)
+      c.push(1);
+  }};
+
+  size_t received = 0;
+  size_t pushed = 0;
+  while (received < totalElements + pushed) {
+    if (auto value = c.try_pop())
+      received += *value;
+    else
+      std::this_thread::yield();
+    if (pushed < totalElements && c.try_push(1))
+      pushed++;
+  }
+
+  writer.join();
+  ASSERT_EQ(received, totalElements + pushed);
+  ASSERT_FALSE(c.try_pop().has_value());
+}
+
 TEST(chanel, iteration_without_buffer) {
   std::array<size_t, 3> values{2, 6, 42};
 
@@ -216,14 +216,39 @@ template <typename T, typename Allocator = std::allocator<T>> struct chanelN : p
     if (status == CLOSED)
       return {};
 
-    auto defer = deferred([&, this]() {
-      size_--;
-      std::destroy_at(&buffer_[pos]);
-      buffer_status_[pos].store(is_closed() ? CLOSED : EMPTY);
-      buffer_status_[pos].notify_one();
-    });
+    return read(pos);
+  }
 
-    return std::move(buffer_[pos]);
+  /**
+   * try_push inserts an element only if it can be done without waiting. If the element
+   * is not inserted, it is not moved.
+   *
+   * \return true if the element was inserted. false if the chanel is full or closed.
+   */
+  bool try_push(const_reference v) { return internal_try_push(v); }
+
+  bool try_push(universal_reference v) { return internal_try_push(std::move(v)); }
+
+  /**
+   * try_pop returns the first element if it can be read without waiting. It is meant for
+   * chanels with only one consumer that has other work to do while the chanel is empty.
+   *
+   * \return An optional with the value or an empty optional if there isn't a readable element.
+   */
+  std::optional<value_type> try_pop() {
+    size_t pos = start_.load();
+    auto status = buffer_status_[pos].load();
+    if (status != CAN_READ && status != CAN_READ_CLOSING)
+      return {};
+
+    // Only the reader that moves the start owns the slot
+    if (!start_.compare_exchange_strong(pos, (pos + 1) % capacity_))
+      return {};
+
+    while (!buffer_status_[pos].compare_exchange_weak(status, READING))
+      status = buffer_status_[pos].load();
+
+    return read(pos);
   }
 
   void close() override {
@@ -269,12 +294,50 @@ private:
     if (is_closed())
       return false;
 
+    write(pos, std::forward<U>(v));
+    return true;
+  }
+
+  template <typename U> bool internal_try_push(U &&v) {
+    const size_t pos = end_.load();
+    if (is_closed())
+      return false;
+
+    // The slot is taken before moving the end, like the sequence of a slot in a Vyukov bounded
+    // queue. If it is not empty, maybe because a blocked writer of the previous lap is waiting
+    // for it, the chanel is full: waiting for it could block forever
+    auto status = EMPTY;
+    if (!buffer_status_[pos].compare_exchange_strong(status, WRITING))
+      return false;
+
+    // Another writer moved the end first, the slot is given back to it
+    size_t expected = pos;
+    if (is_closed() || !end_.compare_exchange_strong(expected, (pos + 1) % capacity_)) {
+      buffer_status_[pos].store(is_closed() ? CLOSED : EMPTY);
+      buffer_status_[pos].notify_all();
+      return false;
+    }
+
+    write(pos, std::forward<U>(v));
+    return true;
+  }
+
+  template <typename U> void write(size_t pos, U &&v) {
     std::construct_at(&buffer_[pos], std::forward<U>(v));
     size_++;
     buffer_status_[pos].store(CAN_READ);
     buffer_status_[pos].notify_one();
+  }
 
-    return true;
+  value_type read(size_t pos) {
+    auto defer = deferred([&, this]() {
+      size_--;
+      std::destroy_at(&buffer_[pos]);
+      buffer_status_[pos].store(is_closed() ? CLOSED : EMPTY);
+      buffer_status_[pos].notify_one();
+    });
+
+    return std::move(buffer_[pos]);
   }
 
 private:
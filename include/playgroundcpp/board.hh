@@ -0,0 +1,143 @@
+#ifndef PLAYGROUNDCPP_BOARD_HH__
+#define PLAYGROUNDCPP_BOARD_HH__
+#include <cstdint>
+
+/* Kernels for a 15 puzzle stored in a 64 bit value, 4 bits per position, where 0 is
+ * the hole and the position 0 is the lowest nibble. They work on the whole word at
+ * once (SWAR) instead of looping over the positions, and all of them are constexpr,
+ * so the same code runs in the runtime solvers and in the template solver.
+ *
+ * The directions are the moves of the hole: 0 up (+4), 1 right (-1), 2 down (-4)
+ * and 3 left (+1).
+ */
+namespace playgroundcpp {
+
+namespace board {
+
+    constexpr uint64_t nibble_lsb = 0x1111'1111'1111'1111ull;
+
+    constexpr int no_hole = 16;
+
+    /**
+     * returns a word with the lowest bit of every zero nibble set.
+     */
+    constexpr uint64_t zero_nibbles(uint64_t b) {
+        uint64_t t = b | (b >> 1);
+        t |= t >> 2;
+        return ~t & nibble_lsb;
+    }
+
+    /**
+     * returns the position of the hole or no_hole if there is not a zero nibble.
+     */
+    constexpr int hole_position(uint64_t b) {
+        uint64_t zeros = zero_nibbles(b);
+        return zeros ? __builtin_ctzll(zeros) / 4 : no_hole;
+    }
+
+    /**
+     * legal_moves[hole] has the bit d set when the hole can move in the direction d.
+     */
+    constexpr uint8_t legal_moves[16] = {
+        0b1001, 0b1011, 0b1011, 0b0011,
+        0b1101, 0b1111, 0b1111, 0b0111,
+        0b1101, 0b1111, 0b1111, 0b0111,
+        0b1100, 0b1110, 0b1110, 0b0110,
+    };
+
+    /**
+     * offset[d] is the position of the moved tile relative to the hole.
+     */
+    constexpr int offset[4] = {4, -1, -4, 1};
+
+    constexpr bool can_move(int hole, int direction) {
+        return hole >= 0 && hole < 16 && direction >= 0 && direction < 4 && (legal_moves[hole] >> direction) & 1;
+    }
+
+    /**
+     * tile_move describes a move: the new board, the tile that was moved and the positions
+     * it moved from and to. The hole moves the other way.
+     */
+    struct tile_move {
+        uint64_t board;
+        uint8_t tile;
+        uint8_t from;
+        uint8_t to;
+    };
+
+    /**
+     * moves the hole, that is in the position hole. The move must be legal; otherwise
+     * the result is meaningless, but it can still be evaluated at compile time.
+     */
+    constexpr tile_move move_hole(uint64_t b, int hole, int direction) {
+        hole &= 15;
+        int from = (hole + offset[direction & 3]) & 15;
+        uint64_t tile = (b >> (4 * from)) & 0xf;
+        return {(b & ~(0xfull << (4 * from))) | (tile << (4 * hole)), static_cast<uint8_t>(tile), static_cast<uint8_t>(from),
+                static_cast<uint8_t>(hole)};
+    }
+
+    /**
+     * successors are all the legal moves of a board, in the order of the directions.
+     */
+    struct successors {
+        tile_move moves[4];
+        uint8_t directions[4];
+        int count;
+    };
+
+    constexpr successors successors_of(uint64_t b) {
+        successors result{};
+        int hole = hole_position(b);
+        if (hole == no_hole)
+            return result;
+        for (uint8_t d = 0; d < 4; d++) {
+            if (!((legal_moves[hole] >> d) & 1))
+                continue;
+            result.moves[result.count] = move_hole(b, hole, d);
+            result.directions[result.count] = d;
+            result.count++;
+        }
+        return result;
+    }
+
+    /**
+     * counts the pairs of tiles that are in the wrong order reading the board left to right
+     * and top to bottom, that is from the highest nibble. The tiles already read are kept in
+     * a bit set, so every tile is one shift and one popcount.
+     */
+    constexpr int inversions(uint64_t b) {
+        unsigned seen = 0;
+        int count = 0;
+        for (int position = 15; position >= 0; position--) {
+            unsigned tile = (b >> (4 * position)) & 0xf;
+            count += __builtin_popcount(seen >> tile) & -static_cast<int>(tile != 0);
+            seen |= (1u << tile) & ~1u;
+        }
+        return count;
+    }
+
+    /**
+     * In a board with an even width, every vertical move of the hole changes the parity of
+     * the inversions. The board is solvable when the parity of the inversions plus the row
+     * of the hole (counted from the bottom, where it is in the solved board) is even.
+     */
+    constexpr bool is_solvable(uint64_t b) {
+        return ((inversions(b) + hole_position(b) / 4) & 1) == 0;
+    }
+
+    static_assert(hole_position(0x1234'5678'9abc'def0) == 0);
+    static_assert(hole_position(0x0123'4567'89ab'cdef) == 15);
+    static_assert(hole_position(0x1234'5067'89ab'cdef) == 10);
+    static_assert(hole_position(0xf123'4567'89ab'cdef) == no_hole);
+    static_assert(inversions(0x1234'5678'9abc'def0) == 0);
+    static_assert(inversions(0xd2a3'1c84'5096'feb7) == 41);
+    static_assert(is_solvable(0x1234'5678'9abc'def0));
+    static_assert(!is_solvable(0x1234'5678'9abc'dfe0));
+    static_assert(move_hole(0x1234'5678'9abc'def0, 0, 0).board == 0x1234'5678'9ab0'defc);
+    static_assert(successors_of(0x1234'5678'9abc'def0).count == 2);
+    static_assert(successors_of(0x1234'5067'89ab'cdef).count == 4);
+    static_assert(successors_of(0x0123'4567'89ab'cdef).moves[1].board == 0x4123'0567'89ab'cdef);
+}
+}
+#endif
@@ -4,6 +4,11 @@
 #include <cstdint>
 #include <type_traits>
 
+/* The hole position and the moves are computed with the same kernels the runtime
+ * solvers use.
+ */
+#include <playgroundcpp/board.hh>
+
 /* When an action (structs with its name in lower case), cannot do its operation,
  * it returns Nothing.
  * All actions returns a 'type'.
@@ -38,23 +43,10 @@ enum Movement: long {
     Left
 };
 
-template<uint64_t Puz, uint64_t Pos>
-struct __get_hole_position {
-    using type = std::conditional_t<
-        (Puz & 0xf) == 0,
-        Long<Pos>,
-        typename __get_hole_position<(Puz >> 4), Pos + 1>::type
-    >;
-};
-
-template<uint64_t Puz>
-struct __get_hole_position<Puz, 16> {
-    using type = Nothing;
-};
-
 template<class MaybePuzzle>
 struct get_hole_position {
-    using type = typename __get_hole_position<MaybePuzzle::value, 0>::type;
+    static constexpr int position = playgroundcpp::board::hole_position(MaybePuzzle::value);
+    using type = std::conditional_t<position == playgroundcpp::board::no_hole, Nothing, Long<position>>;
 };
 
 template<>
@@ -84,70 +76,15 @@ static_assert(std::is_same_v<get_hole_position_t<Long<0x1023456789abcdef>>, Long
 static_assert(std::is_same_v<get_hole_position_t<Long<0x0123456789abcdef>>, Long<15>>);
 static_assert(std::is_same_v<get_hole_position_t<Long<0xf123456789abcdef>>, Nothing>);
 
-template<bool Condition, uint64_t Pos, Movement M, uint64_t Puz>
-struct __move;
-
-template<uint64_t Pos, uint64_t Puz>
-struct __move<true, Pos, Up, Puz> {
-    using type = Long<
-        (Puz & ~(0xfull << (4 * (Pos + 4)))) |
-        ((Puz &  (0xfull << (4 * (Pos + 4)))) >> 16)
-    >;
-};
-template<uint64_t Pos, uint64_t Puz>
-struct __move<true, Pos, Right, Puz> {
-    using type = Long<
-        (Puz & ~(0xfull << (4 * (Pos - 1)))) |
-        ((Puz &  (0xfull << (4 * (Pos - 1)))) << 4)
-    >;
-};
-template<uint64_t Pos, uint64_t Puz>
-struct __move<true, Pos, Down, Puz> {
-    using type = Long<
-        (Puz & ~(0xfull << (4 * (Pos - 4)))) |
-        ((Puz &  (0xfull << (4 * (Pos - 4)))) << 16)
-    >;    
-};
-template<uint64_t Pos, uint64_t Puz>
-struct __move<true, Pos, Left, Puz> {
-    using type = Long<
-        (Puz & ~(0xfull << (4 * (Pos + 1)))) |
-        ((Puz &  (0xfull << (4 * (Pos + 1)))) >> 4)
-    >;    
-};
-
-template<uint64_t Pos, Movement M, uint64_t Puz>
-struct __move<false, Pos, M, Puz> {
-    using type = Nothing;
-};
-
-template<bool Condition, uint64_t Pos, Movement M, uint64_t Puz>
-using __move_t = typename __move<Condition, Pos, M, Puz>::type;
-
-static_assert(std::is_same_v<__move_t<false, 0, Up, 0>, Nothing>);
-
 template<Movement M, class MaybePuzzle>
-struct move;
-
-template<class MaybePuzzle>
-struct move<Up, MaybePuzzle> {
-    using type = __move_t<get_hole_position_t<MaybePuzzle>::value / 4 != 3, get_hole_position_t<MaybePuzzle>::value, Up   , MaybePuzzle::value>;
-    static constexpr Movement direction = Up;
-};
-template<class MaybePuzzle>
-struct move<Right, MaybePuzzle> {
-    using type = __move_t<get_hole_position_t<MaybePuzzle>::value % 4 != 0, get_hole_position_t<MaybePuzzle>::value, Right, MaybePuzzle::value>;
-    static constexpr Movement direction = Right;
-};
-template<class MaybePuzzle>
-struct move<Down, MaybePuzzle> {
-    using type = __move_t<get_hole_position_t<MaybePuzzle>::value / 4 != 0, get_hole_position_t<MaybePuzzle>::value, Down , MaybePuzzle::value>;
-    static constexpr Movement direction = Down;
-};
-template<class MaybePuzzle>
-struct move<Left, MaybePuzzle> {
-    using type = __move_t<get_hole_position_t<MaybePuzzle>::value % 4 != 3, get_hole_position_t<MaybePuzzle>::value, Left , MaybePuzzle::value>;
-    static constexpr Movement direction = Left;
+struct move {
+    static constexpr int hole = playgroundcpp::board::hole_position(MaybePuzzle::value);
+    using type = std::conditional_t<
+        playgroundcpp::board::can_move(hole, M),
+        Long<playgroundcpp::board::move_hole(MaybePuzzle::value, hole, M).board>,
+        Nothing
+    >;
+    static constexpr Movement direction = M;
 };
 
 /* Try to move nothing results nothing */